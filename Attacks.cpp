@@ -0,0 +1,128 @@
+#include "Attacks.hpp"
+
+Magic ROOK_MAGICS[64];
+Magic BISHOP_MAGICS[64];
+Bitboard BETWEEN_BB[64][64];
+Bitboard LINE_BB[64][64];
+
+namespace {
+
+Bitboard rookTable[0x19000];
+Bitboard bishopTable[0x1480];
+
+const int ROOK_DELTAS[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+const int BISHOP_DELTAS[4][2] = { {1, 1}, {-1, 1}, {1, -1}, {-1, -1} };
+
+// Reference ray walk, only used to fill the lookup tables.
+Bitboard slidingAttacks(int sq, Bitboard occupied, const int deltas[4][2]) {
+    Bitboard attacks = 0;
+    for (int d = 0; d < 4; ++d) {
+        int file = fileOf(sq) + deltas[d][0];
+        int rank = rankOf(sq) + deltas[d][1];
+        while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+            Bitboard bb = squareBB(makeSquare(file, rank));
+            attacks |= bb;
+            if (occupied & bb)
+                break;
+            file += deltas[d][0];
+            rank += deltas[d][1];
+        }
+    }
+    return attacks;
+}
+
+// xorshift64* generator; fixed seeds make the magic search deterministic.
+class Prng {
+public:
+    explicit Prng(uint64_t seed) : state(seed) {}
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
+    // Magics with few set bits are found much faster.
+    uint64_t sparse() { return next() & next() & next(); }
+
+private:
+    uint64_t state;
+};
+
+void initMagics(Magic magics[64], Bitboard *table, const int deltas[4][2]) {
+    const uint64_t seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+    Bitboard occupancy[4096], reference[4096];
+    int epoch[4096] = {}, attempt = 0;
+
+    for (int sq = 0; sq < 64; ++sq) {
+        Magic &m = magics[sq];
+        Bitboard edges = ((RANK_1 | RANK_8) & ~(RANK_1 << (8 * rankOf(sq))))
+                         | ((FILE_A | FILE_H) & ~(FILE_A << fileOf(sq)));
+        m.mask = slidingAttacks(sq, 0, deltas) & ~edges;
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = table;
+
+        // Enumerate every subset of the mask (Carry-Rippler) with its true attack set.
+        int size = 0;
+        Bitboard b = 0;
+        do {
+            occupancy[size] = b;
+            reference[size] = slidingAttacks(sq, b, deltas);
+#if defined(CHESS_USE_PEXT)
+            m.attacks[m.index(b)] = reference[size];
+#endif
+            ++size;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+        table += size;
+
+#if !defined(CHESS_USE_PEXT)
+        Prng rng(seeds[rankOf(sq)]);
+        for (int i = 0; i < size; ) {
+            m.magic = 0;
+            while (popCount((m.magic * m.mask) >> 56) < 6)
+                m.magic = rng.sparse();
+
+            // epoch marks which slots were written by the current candidate, so
+            // the table does not need clearing between attempts.
+            ++attempt;
+            for (i = 0; i < size; ++i) {
+                unsigned idx = m.index(occupancy[i]);
+                if (epoch[idx] < attempt) {
+                    epoch[idx] = attempt;
+                    m.attacks[idx] = reference[i];
+                } else if (m.attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+#endif
+    }
+}
+
+void initLines() {
+    for (int a = 0; a < 64; ++a) {
+        for (int b = 0; b < 64; ++b) {
+            if (a == b)
+                continue;
+            if (rookAttacks(a, 0) & squareBB(b)) {
+                LINE_BB[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | squareBB(a) | squareBB(b);
+                BETWEEN_BB[a][b] = rookAttacks(a, squareBB(b)) & rookAttacks(b, squareBB(a));
+            } else if (bishopAttacks(a, 0) & squareBB(b)) {
+                LINE_BB[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | squareBB(a) | squareBB(b);
+                BETWEEN_BB[a][b] = bishopAttacks(a, squareBB(b)) & bishopAttacks(b, squareBB(a));
+            }
+        }
+    }
+}
+
+struct AttackTablesInit {
+    AttackTablesInit() {
+        initMagics(ROOK_MAGICS, rookTable, ROOK_DELTAS);
+        initMagics(BISHOP_MAGICS, bishopTable, BISHOP_DELTAS);
+        initLines();
+    }
+};
+
+const AttackTablesInit attackTablesInit;
+
+}
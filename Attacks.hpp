@@ -0,0 +1,90 @@
+#ifndef ATTACKS_HPP
+#define ATTACKS_HPP
+
+#include <array>
+#include "Bitboard.hpp"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#define CHESS_USE_PEXT 1
+#endif
+
+namespace detail {
+
+constexpr int KNIGHT_DELTAS[8][2] = { {2, 1}, {1, 2}, {-1, 2}, {-2, 1}, {-2, -1}, {-1, -2}, {1, -2}, {2, -1} };
+constexpr int KING_DELTAS[8][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, 1}, {1, -1}, {-1, -1} };
+constexpr int WHITE_PAWN_DELTAS[2][2] = { {-1, 1}, {1, 1} };
+constexpr int BLACK_PAWN_DELTAS[2][2] = { {-1, -1}, {1, -1} };
+
+template <int N>
+constexpr std::array<Bitboard, 64> makeStepTable(const int (&deltas)[N][2]) {
+    std::array<Bitboard, 64> table{};
+    for (int sq = 0; sq < 64; ++sq) {
+        for (int i = 0; i < N; ++i) {
+            int file = fileOf(sq) + deltas[i][0];
+            int rank = rankOf(sq) + deltas[i][1];
+            if (file >= 0 && file < 8 && rank >= 0 && rank < 8)
+                table[sq] |= squareBB(makeSquare(file, rank));
+        }
+    }
+    return table;
+}
+
+}
+
+// Leaper attacks, built by the compiler.
+constexpr std::array<Bitboard, 64> KNIGHT_ATTACKS = detail::makeStepTable(detail::KNIGHT_DELTAS);
+constexpr std::array<Bitboard, 64> KING_ATTACKS = detail::makeStepTable(detail::KING_DELTAS);
+constexpr std::array<Bitboard, 64> PAWN_ATTACKS[2] = {
+    detail::makeStepTable(detail::WHITE_PAWN_DELTAS),
+    detail::makeStepTable(detail::BLACK_PAWN_DELTAS)
+};
+
+// Slider attacks come from one table lookup per square. The table index is
+// PEXT of the relevant occupancy when BMI2 is available, otherwise a magic
+// multiply found at startup.
+struct Magic {
+    Bitboard mask;   // relevant occupancy, board edges excluded
+    Bitboard magic;
+    Bitboard *attacks;
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const {
+#if defined(CHESS_USE_PEXT)
+        return unsigned(_pext_u64(occupied, mask));
+#else
+        return unsigned(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Magic ROOK_MAGICS[64];
+extern Magic BISHOP_MAGICS[64];
+
+// Squares strictly between two aligned squares, and the full line through them.
+// Both are empty when the squares do not share a rank, file or diagonal.
+extern Bitboard BETWEEN_BB[64][64];
+extern Bitboard LINE_BB[64][64];
+
+inline Bitboard pawnAttacks(Color c, int sq) { return PAWN_ATTACKS[c][sq]; }
+inline Bitboard knightAttacks(int sq) { return KNIGHT_ATTACKS[sq]; }
+inline Bitboard kingAttacks(int sq) { return KING_ATTACKS[sq]; }
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupied) {
+    const Magic &m = BISHOP_MAGICS[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard rookAttacks(int sq, Bitboard occupied) {
+    const Magic &m = ROOK_MAGICS[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupied) {
+    return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+}
+
+inline Bitboard betweenBB(int a, int b) { return BETWEEN_BB[a][b]; }
+inline Bitboard lineBB(int a, int b) { return LINE_BB[a][b]; }
+
+#endif // ATTACKS_HPP
@@ -0,0 +1,67 @@
+#ifndef BITBOARD_HPP
+#define BITBOARD_HPP
+
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// One bit per square. Square 0 is a1, square 7 is h1, square 63 is h8.
+typedef uint64_t Bitboard;
+
+enum Color : uint8_t { WHITE, BLACK };
+enum PieceType : uint8_t { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING, NO_PIECE_TYPE };
+
+// Piece codes index Position::pieces: white pawn .. white king, black pawn .. black king.
+enum PieceCode : uint8_t {
+    W_PAWN, W_KNIGHT, W_BISHOP, W_ROOK, W_QUEEN, W_KING,
+    B_PAWN, B_KNIGHT, B_BISHOP, B_ROOK, B_QUEEN, B_KING,
+    NO_PIECE
+};
+
+const int NO_SQUARE = 64;
+
+const Bitboard FILE_A = 0x0101010101010101ULL;
+const Bitboard FILE_H = FILE_A << 7;
+const Bitboard RANK_1 = 0xFFULL;
+const Bitboard RANK_2 = RANK_1 << 8;
+const Bitboard RANK_7 = RANK_1 << 48;
+const Bitboard RANK_8 = RANK_1 << 56;
+
+constexpr Color operator~(Color c) { return Color(c ^ 1); }
+
+constexpr PieceCode makePiece(Color c, PieceType t) { return PieceCode(c * 6 + t); }
+constexpr Color colorOf(PieceCode p) { return Color(p / 6); }
+constexpr PieceType typeOf(PieceCode p) { return PieceType(p % 6); }
+
+constexpr int makeSquare(int file, int rank) { return rank * 8 + file; }
+constexpr int fileOf(int sq) { return sq & 7; }
+constexpr int rankOf(int sq) { return sq >> 3; }
+constexpr Bitboard squareBB(int sq) { return 1ULL << sq; }
+
+inline int popCount(Bitboard b) {
+#if defined(_MSC_VER)
+    return int(__popcnt64(b));
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+// Index of the least significant set bit. b must be non-zero.
+inline int lsb(Bitboard b) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward64(&idx, b);
+    return int(idx);
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+inline int popLsb(Bitboard &b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+#endif // BITBOARD_HPP
@@ -0,0 +1,46 @@
+#ifndef BOOK_HPP
+#define BOOK_HPP
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include "MappedFile.hpp"
+#include "Position.hpp"
+
+// Opening book in the Polyglot .bin format: 16-byte big-endian entries
+// (key, move, weight, learn) sorted by key. The file stays memory-mapped
+// and is searched in place, so a book of any size opens at once and a
+// probe touches only the few pages on the binary search path.
+class OpeningBook {
+public:
+    // Maps the book at path, replacing the one open before. False if the
+    // file cannot be read or is not a whole number of entries.
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return entryCount > 0; }
+
+    // A legal book move for pos, or Move() if the position is not in the
+    // book. With bestOnly the highest weight wins, otherwise moves are drawn
+    // in proportion to their weights.
+    Move probe(const Position &pos, bool bestOnly);
+
+    // Polyglot hash of pos.
+    static uint64_t key(const Position &pos);
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint16_t move;
+        uint16_t weight;
+    };
+
+    Entry entryAt(size_t index) const;
+    // The legal move of pos that the Polyglot move encoding stands for.
+    static Move decodeMove(const Position &pos, uint16_t move);
+
+    MappedFile file;
+    size_t entryCount = 0;
+    std::mt19937_64 random{std::random_device{}()};
+};
+
+#endif // BOOK_HPP
@@ -1,67 +1,128 @@
 #include "ChessBoard.hpp"
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <fstream>
 #include <SFML/Window.hpp>
-#include "Piece.hpp"
 #include "GameEnhancer.hpp"
+#include "Pgn.hpp"
 
 using namespace std;
 const string FIGURE_PATH2 = R"(C:\project\chess\figures\)";
 const string FONT_PATH = R"(C:\project\chess\)";
-ChessBoard::ChessBoard() {
-    initBoard();
-
+namespace {
 
-    pieceSelected = false;
+const PieceType PROMOTION_CHOICES[4] = { QUEEN, ROOK, BISHOP, KNIGHT };
 
+// Promotion picker cells, side by side in the middle of the board.
+sf::FloatRect promotionCell(int i) {
+    return sf::FloatRect(200.f + i * 100.f, 350.f, 100.f, 100.f);
 }
 
-ChessBoard::~ChessBoard() {
+const sf::FloatRect RESTART_BUTTON(350.f, 410.f, 100.f, 50.f);
 
-    for (auto& row : board) {
-        for (auto& piece : row) {
-            delete piece;
-        }
+const int HINT_SEGMENTS = 24;
+
+// A filled circle as a fan of triangles, for an sf::Triangles array.
+void appendCircle(sf::VertexArray& vertices, sf::Vector2f center, float radius, sf::Color color) {
+    for (int i = 0; i < HINT_SEGMENTS; ++i) {
+        float a0 = 2 * 3.14159265f * i / HINT_SEGMENTS;
+        float a1 = 2 * 3.14159265f * (i + 1) / HINT_SEGMENTS;
+        vertices.append(sf::Vertex(center, color));
+        vertices.append(sf::Vertex(center + sf::Vector2f(radius * cos(a0), radius * sin(a0)), color));
+        vertices.append(sf::Vertex(center + sf::Vector2f(radius * cos(a1), radius * sin(a1)), color));
     }
 }
 
-void ChessBoard::initBoard() {
-    // �������
-    for (auto& row : board) {
-        for (auto& piece : row) {
-            delete piece;
-            piece = nullptr;
-        }
-    }
+// Screen coordinates have row 0 at the top (rank 8); squares count from a1.
+int toSquare(int x, int y) {
+    return makeSquare(x, 7 - y);
+}
+
+sf::Vector2i toScreen(int sq) {
+    return sf::Vector2i(fileOf(sq), 7 - rankOf(sq));
+}
 
-    board.clear();
-    board.resize(8, vector<Piece*>(8, nullptr));
+}
 
+ChessBoard::ChessBoard(size_t hashMb, bool hugePages, int threads)
+    : engine(transpositionTable), engineRequest(0), engineSide{false, false}, boardVertices(sf::Quads),
+      pieceVertices(sf::Quads), pieceVerticesKey(0), hintVertices(sf::Triangles), overlay(OVERLAY_NONE), promotionFrom(NO_SQUARE), promotionTo(NO_SQUARE), winner(WHITE) {
+    atlas.load(FIGURE_PATH2);
+
+    // The squares never change: build them once.
+    sf::Color lightSquare(230, 207, 171);
+    sf::Color darkSquare(161, 116, 79);
     for (int i = 0; i < 8; ++i) {
-        board[1][i] = new Pawn(Piece::Color::Black);
-        board[6][i] = new Pawn(Piece::Color::White);
+        for (int j = 0; j < 8; ++j) {
+            sf::Color color = (i + j) % 2 == 0 ? lightSquare : darkSquare;
+            float left = i * 100.f, top = j * 100.f;
+            boardVertices.append(sf::Vertex(sf::Vector2f(left, top), color));
+            boardVertices.append(sf::Vertex(sf::Vector2f(left + 100, top), color));
+            boardVertices.append(sf::Vertex(sf::Vector2f(left + 100, top + 100), color));
+            boardVertices.append(sf::Vertex(sf::Vector2f(left, top + 100), color));
+        }
     }
+    if (!font.loadFromFile(FONT_PATH + "arial.ttf")) {
+        cerr << "Failed to load font.\n";
+    }
+
+    enhancer.setMoveFormatter([this](size_t ply) { return historyLine(ply); });
+    transpositionTable.resize(hashMb, hugePages);
+    engine.setThreads(threads);
+    initBoard();
 
-    board[0][0] = new Rook(Piece::Color::Black);
-    board[0][7] = new Rook(Piece::Color::Black);
-    board[7][0] = new Rook(Piece::Color::White);
-    board[7][7] = new Rook(Piece::Color::White);
 
-    board[0][1] = new Knight(Piece::Color::Black);
-    board[0][6] = new Knight(Piece::Color::Black);
-    board[7][1] = new Knight(Piece::Color::White);
-    board[7][6] = new Knight(Piece::Color::White);
+    pieceSelected = false;
+
+}
+
+void ChessBoard::initBoard() {
+    game.reset();
+    // The engine thread clears the table once its search has unwound.
+    engine.newGame();
+    engineRequest = 0;
+    enhancer.reset();
+    enhancer.setEngineInfo("");
+    overlay = OVERLAY_NONE;
+    pieceSelected = false;
+    selectedMoves.clear();
+}
 
-    board[0][2] = new Bishop(Piece::Color::Black);
-    board[0][5] = new Bishop(Piece::Color::Black);
-    board[7][2] = new Bishop(Piece::Color::White);
-    board[7][5] = new Bishop(Piece::Color::White);
+bool ChessBoard::loadFen(string_view fen) {
+    if (!game.reset(fen))
+        return false;
+    engine.newGame();
+    engineRequest = 0;
+    enhancer.reset(game.sideToMove() == WHITE);
+    enhancer.setEngineInfo("");
+    overlay = OVERLAY_NONE;
+    pieceSelected = false;
+    selectedMoves.clear();
+    hintVertices.clear();
+    return true;
+}
 
-    board[0][3] = new Queen(Piece::Color::Black);
-    board[7][3] = new Queen(Piece::Color::White);
+bool ChessBoard::savePgn(const string& path) const {
+    string_view result = "*";
+    if (game.isCheckmate())
+        result = game.sideToMove() == WHITE ? "0-1" : "1-0";
+    else if (enhancer.gameOverDueToTime)
+        result = enhancer.getTimeOverLoser() == "White" ? "0-1" : "1-0";
+    vector<PgnTag> tags = {
+        { "White", engineSide[WHITE] ? "Engine" : "Player" },
+        { "Black", engineSide[BLACK] ? "Engine" : "Player" },
+    };
+    ofstream out(path, ios::binary);
+    out << writePgn(game, tags, result);
+    return bool(out);
+}
 
-    board[0][4] = new King(Piece::Color::Black);
-    board[7][4] = new King(Piece::Color::White);
+string ChessBoard::historyLine(size_t ply) const {
+    const Position& start = game.getStartPosition();
+    size_t counted = ply + (start.sideToMove == BLACK ? 1 : 0);
+    string number = to_string(start.fullmoveNumber + counted / 2) + (counted % 2 == 0 ? ". " : "... ");
+    return number + game.getSan(ply);
 }
 
 void ChessBoard::draw(sf::RenderWindow& window) {
@@ -72,77 +133,103 @@ void ChessBoard::draw(sf::RenderWindow& window) {
 
         drawHints(window);
     }
+    enhancer.setEvaluation(getEvaluation());
     enhancer.drawExtras(window);
+    drawOverlay(window);
 }
 
 void ChessBoard::handleEvent(const sf::Event& event) {
-    static Piece::Color currentPlayer = Piece::Color::White;
-
-    if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+    if (enhancer.handleEvent(event))
+        return;
+    if (overlay != OVERLAY_NONE) {
+        handleOverlayEvent(event);
+        return;
+    }
+    if (event.type == sf::Event::KeyPressed && (event.key.code == sf::Keyboard::W || event.key.code == sf::Keyboard::B)) {
+        Color side = event.key.code == sf::Keyboard::W ? WHITE : BLACK;
+        engineSide[side] = !engineSide[side];
+        enhancer.setEngineSides(engineSide[WHITE], engineSide[BLACK]);
+        if (engineRequest && !engineSide[game.sideToMove()]) {
+            engine.cancel();
+            engineRequest = 0;
+            enhancer.setEngineInfo("");
+        }
+        pieceSelected = false;
+        selectedMoves.clear();
+        hintVertices.clear();
+    }
+    // Ctrl+C copies the position as FEN, Ctrl+V sets one up from the clipboard.
+    if (event.type == sf::Event::KeyPressed && event.key.control && event.key.code == sf::Keyboard::C) {
+        sf::Clipboard::setString(getFen());
+        return;
+    }
+    if (event.type == sf::Event::KeyPressed && event.key.control && event.key.code == sf::Keyboard::V) {
+        if (!loadFen(sf::Clipboard::getString().toAnsiString()))
+            cerr << "Clipboard does not hold a valid FEN\n";
+        return;
+    }
+    // Ctrl+S saves the game next to the executable.
+    if (event.type == sf::Event::KeyPressed && event.key.control && event.key.code == sf::Keyboard::S) {
+        if (savePgn("game.pgn"))
+            cout << "Saved game.pgn\n";
+        else
+            cerr << "Could not write game.pgn\n";
+        return;
+    }
+    // Backspace takes back the last move, and the engine's reply with it
+    // when the engine would otherwise move again straight away.
+    if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Backspace) {
+        if (engineRequest) {
+            engine.cancel();
+            engineRequest = 0;
+            enhancer.setEngineInfo("");
+        }
+        if (game.undoMove()) {
+            // Taking back a mate reopens the game; a fallen flag stays fallen.
+            if (!enhancer.gameOverDueToTime)
+                enhancer.resumeClocks();
+            enhancer.undoMove();
+            if (engineSide[game.sideToMove()] && !engineSide[~game.sideToMove()] && game.undoMove())
+                enhancer.undoMove();
+        }
+        pieceSelected = false;
+        selectedMoves.clear();
+        hintVertices.clear();
+    }
+    // The board ignores clicks while the engine is to move.
+    if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left
+        && !engineSide[game.sideToMove()]) {
         int x = event.mouseButton.x / 100;
         int y = event.mouseButton.y / 100;
+        bool onBoard = x >= 0 && x < 8 && y >= 0 && y < 8;
         if (pieceSelected) {
-            auto validMoves = getValidMoves(selectedPiece.x, selectedPiece.y);
-            validMoves.erase(remove_if(validMoves.begin(), validMoves.end(), [this](sf::Vector2i move) {
-                return !willMovePreventCheck(selectedPiece.x, selectedPiece.y, move.x, move.y, board[selectedPiece.y][selectedPiece.x]->getColor());
-            }), validMoves.end());
-            sf::Vector2i target(x, y);
-            if (find(validMoves.begin(), validMoves.end(), target) != validMoves.end()) {
-                if (dynamic_cast<King*>(board[selectedPiece.y][selectedPiece.x])) {
-                    if (target.x == selectedPiece.x - 2) {
-                        swap(board[selectedPiece.y][selectedPiece.x], board[target.y][target.x]);
-                        swap(board[target.y][0], board[target.y][target.x + 1]);
-                        dynamic_cast<King*>(board[target.y][target.x])->hasMoved = true;
-                        dynamic_cast<Rook*>(board[target.y][target.x + 1])->hasMoved = true;
-                    }
-                    else if (target.x == selectedPiece.x + 2) {
-                        swap(board[selectedPiece.y][selectedPiece.x], board[target.y][target.x]);
-                        swap(board[target.y][7], board[target.y][target.x - 1]);
-                        dynamic_cast<King*>(board[target.y][target.x])->hasMoved = true;
-                        dynamic_cast<Rook*>(board[target.y][target.x - 1])->hasMoved = true;
-                    }
-                    else {
-                        if (board[target.y][target.x] != nullptr) {
-                            delete board[target.y][target.x];
-                        }
-                        board[target.y][target.x] = board[selectedPiece.y][selectedPiece.x];
-                        board[selectedPiece.y][selectedPiece.x] = nullptr;
-                        dynamic_cast<King*>(board[target.y][target.x])->hasMoved = true;
-                    }
+            int from = toSquare(selectedPiece.x, selectedPiece.y);
+            int to = onBoard ? toSquare(x, y) : NO_SQUARE;
+            auto it = find_if(selectedMoves.begin(), selectedMoves.end(), [from, to](const Move& move) {
+                return move.from() == from && move.to() == to;
+            });
+            if (it != selectedMoves.end()) {
+                if (it->type() == PROMOTION) {
+                    // The move is played once a piece is picked in the overlay.
+                    promotionFrom = from;
+                    promotionTo = to;
+                    overlay = OVERLAY_PROMOTION;
                 }
                 else {
-                    if (board[y][x] != nullptr) {
-                        delete board[y][x];
-                        board[y][x] = nullptr;
-                    }
-                    swap(board[selectedPiece.y][selectedPiece.x], board[y][x]);
-                    promotePawnIfNecessary(y, x);
+                    finishMove(*it);
                 }
-                enhancer.recordMove(selectedPiece.x, selectedPiece.y, x, y);
-
-                pieceSelected = false;
-                moveHints.clear();
-                captureHints.clear();
-
-                if (isCheckmate(Piece::Color::White)) {
-                    handleCheckmate(Piece::Color::Black);
-                }
-                else if (isCheckmate(Piece::Color::Black)) {
-                    handleCheckmate(Piece::Color::White);
-                }
-
-                currentPlayer = (currentPlayer == Piece::Color::White) ? Piece::Color::Black : Piece::Color::White;
             }
             else {
 
 
                 pieceSelected = false;
-                moveHints.clear();
-                captureHints.clear();
+                selectedMoves.clear();
+                hintVertices.clear();
             }
         }
-        else {
-            if (board[y][x] != nullptr && board[y][x]->getColor() == currentPlayer) {
+        else if (onBoard) {
+            PieceCode piece = game.getPosition().pieceOn(toSquare(x, y));
+            if (piece != NO_PIECE && colorOf(piece) == game.sideToMove()) {
                 selectedPiece = sf::Vector2i(x, y);
                 pieceSelected = true;
                 auto validMoves = getValidMoves(x, y);
@@ -152,67 +239,91 @@ void ChessBoard::handleEvent(const sf::Event& event) {
     }
 }
 
-void ChessBoard::promotePawnIfNecessary(int y, int x) {
-    if (dynamic_cast<Pawn*>(board[y][x]) && ((board[y][x]->getColor() == Piece::Color::White && y == 0) ||
-                                             (board[y][x]->getColor() == Piece::Color::Black && y == 7))) {
-        Piece* promotedPiece = choosePromotion(board[y][x]->getColor());
-        delete board[y][x];
-        board[y][x] = promotedPiece;
+bool ChessBoard::update() {
+    if (overlay != OVERLAY_NONE)
+        return false;
+    bool changed = false;
+    EngineMessage message;
+    while (engine.poll(message)) {
+        if (message.requestId != engineRequest)
+            continue;
+        changed = true;
+        if (message.type == ENGINE_INFO) {
+            // Best move so far, shown while the engine keeps thinking.
+            const SearchInfo& info = message.info;
+            string line = "depth " + to_string(info.depth) + "  " + toUciString(info.pv[0]);
+            enhancer.setEngineInfo(line);
+        }
+        else {
+            engineRequest = 0;
+            enhancer.setEngineInfo("");
+            if (!enhancer.gameOverDueToTime && !message.result.bestMove.isNone())
+                finishMove(message.result.bestMove);
+        }
     }
-}
 
-Piece* ChessBoard::choosePromotion(Piece::Color color) {
-    return showPromotionDialog(color);
+    Color us = game.sideToMove();
+    if (!engineSide[us] || engineRequest || enhancer.gameOverDueToTime)
+        return changed;
+    MoveList legal;
+    game.getLegalMoves(legal);
+    if (legal.empty())
+        return changed;
+
+    // Think on the remaining clock, which keeps running during the search.
+    SearchLimits limits;
+    limits.timeLeftMs[WHITE] = static_cast<int64_t>(enhancer.getRemainingSeconds(true) * 1000);
+    limits.timeLeftMs[BLACK] = static_cast<int64_t>(enhancer.getRemainingSeconds(false) * 1000);
+    limits.timeLeftMs[us] = max<int64_t>(limits.timeLeftMs[us], 1);
+    engineRequest = engine.startSearch(game.getPosition(), game.getKeyHistory(), limits);
+    return changed;
 }
 
-void ChessBoard::drawBoard(sf::RenderWindow& window) {
-    sf::RectangleShape square(sf::Vector2f(100, 100));
+void ChessBoard::finishMove(const Move& move) {
+    game.playMove(move);
+    enhancer.recordMove();
 
-    sf::Color lightSquare(230, 207, 171);
-    sf::Color darkSquare(161, 116, 79);
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            if ((i + j) % 2 == 0)
-                square.setFillColor(lightSquare);
-            else
-                square.setFillColor(darkSquare);
-            float f;
-            f = static_cast<float>(i);
-            float k;
-            k = static_cast<float>(j);
-            square.setPosition(f * 100, k * 100);
-            window.draw(square);
-        }
+    pieceSelected = false;
+    selectedMoves.clear();
+    hintVertices.clear();
+
+    if (game.isCheckmate()) {
+        handleCheckmate(~game.sideToMove());
     }
 }
 
+void ChessBoard::drawBoard(sf::RenderWindow& window) {
+    window.draw(boardVertices);
+}
+
 void ChessBoard::drawPieces(sf::RenderWindow& window) {
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            if (board[i][j] != nullptr) {
-                board[i][j]->draw(window, j, i);
+    const Position& pos = game.getPosition();
+    if (pieceVertices.getVertexCount() == 0 || pos.key != pieceVerticesKey) {
+        pieceVertices.clear();
+        for (int p = W_PAWN; p <= B_KING; ++p) {
+            for (Bitboard b = pos.pieces[p]; b; ) {
+                sf::Vector2i square = toScreen(popLsb(b));
+                atlas.appendQuad(pieceVertices, PieceCode(p), sf::Vector2f(square.x * 100 + 50.f, square.y * 100 + 50.f));
             }
         }
+        pieceVerticesKey = pos.key;
     }
+    window.draw(pieceVertices, &atlas.getTexture());
 }
 
 void ChessBoard::drawHints(sf::RenderWindow& window) {
-    for (const auto& hint : moveHints) {
-        window.draw(hint);
-    }
-    for (const auto& hint : captureHints) {
-        window.draw(hint);
-    }
+    window.draw(hintVertices);
 }
 
 vector<sf::Vector2i> ChessBoard::getValidMoves(int x, int y) {
+    selectedMoves.clear();
+    game.getLegalMoves(toSquare(x, y), selectedMoves);
     vector<sf::Vector2i> validMoves;
-    if (board[y][x] != nullptr) {
-        auto potentialMoves = board[y][x]->getValidMoves(board, x, y);
-        for (const auto& move : potentialMoves) {
-            if (!wouldBeInCheck(board[y][x], x, y, move.x, move.y)) {
-                validMoves.push_back(move);
-            }
+    for (const Move& move : selectedMoves) {
+        // The four promotion choices share one target square.
+        sf::Vector2i target = toScreen(move.to());
+        if (find(validMoves.begin(), validMoves.end(), target) == validMoves.end()) {
+            validMoves.push_back(target);
         }
     }
     return validMoves;
@@ -221,189 +332,98 @@ vector<sf::Vector2i> ChessBoard::getValidMoves(int x, int y) {
 
 
 void ChessBoard::highlightValidMoves(const vector<sf::Vector2i>& moves) {
-    moveHints.clear();
-    captureHints.clear();
+    hintVertices.clear();
     for (const auto& move : moves) {
-        sf::CircleShape hint(15);
-        hint.setOrigin(15, 15);
-        hint.setPosition(move.x * 100 + 50, move.y * 100 + 50);
-        if (board[move.y][move.x] == nullptr) {
-            hint.setFillColor(sf::Color::Green);
-            moveHints.push_back(hint);
-        }
-        else {
-            hint.setFillColor(sf::Color::Red);
-            captureHints.push_back(hint);
-        }
+        bool capture = game.getPosition().pieceOn(toSquare(move.x, move.y)) != NO_PIECE;
+        appendCircle(hintVertices, sf::Vector2f(move.x * 100 + 50.f, move.y * 100 + 50.f), 15,
+                     capture ? sf::Color::Red : sf::Color::Green);
     }
 }
 
-bool ChessBoard::isInCheck(Piece::Color color) {
-    sf::Vector2i kingPos;
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            if (board[y][x] != nullptr && board[y][x]->getColor() == color && dynamic_cast<King*>(board[y][x]) != nullptr) {
-                kingPos = sf::Vector2i(x, y);
-
-                break;
-
-            }
-        }
-    }
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            if (board[y][x] != nullptr && board[y][x]->getColor() != color) {
-                auto moves = board[y][x]->getValidMoves(board, x, y);
-                if (find(moves.begin(), moves.end(), kingPos) != moves.end()) {
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
+bool ChessBoard::isInCheck(Color color) {
+    return ::isInCheck(game.getPosition(), color);
 }
 
-Piece* ChessBoard::showPromotionDialog(Piece::Color color) {
-    sf::RenderWindow promotionWindow(sf::VideoMode(500, 200), "Choose Promotion");
-    sf::Texture queenTexture, rookTexture, bishopTexture, knightTexture;
-    queenTexture.loadFromFile((color == Piece::Color::White) ? FIGURE_PATH2 + "wQ.png" : FIGURE_PATH2 + "bQ.png");
-    rookTexture.loadFromFile((color == Piece::Color::White) ? FIGURE_PATH2 + "wR.png" : FIGURE_PATH2 + "bR.png");
-    bishopTexture.loadFromFile((color == Piece::Color::White) ? FIGURE_PATH2 + "wB.png" : FIGURE_PATH2 + "bB.png");
-    knightTexture.loadFromFile((color == Piece::Color::White) ? FIGURE_PATH2 + "wN.png" : FIGURE_PATH2 + "bN.png");
-
-    sf::Sprite queenSprite(queenTexture), rookSprite(rookTexture), bishopSprite(bishopTexture), knightSprite(knightTexture);
-    queenSprite.setPosition(50, 50);
-    rookSprite.setPosition(150, 50);
-    bishopSprite.setPosition(250, 50);
-    knightSprite.setPosition(350, 50);
-
-    queenSprite.setOrigin(queenSprite.getLocalBounds().width / 2, queenSprite.getLocalBounds().height / 2);
-    rookSprite.setOrigin(rookSprite.getLocalBounds().width / 2, rookSprite.getLocalBounds().height / 2);
-    bishopSprite.setOrigin(bishopSprite.getLocalBounds().width / 2, bishopSprite.getLocalBounds().height / 2);
-    knightSprite.setOrigin(knightSprite.getLocalBounds().width / 2, knightSprite.getLocalBounds().height / 2);
-
-    while (promotionWindow.isOpen()) {
-        sf::Event event;
-        while (promotionWindow.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) {
-                promotionWindow.close();
-                return new Queen(color);
-            }
-            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-                sf::Vector2i clickPos = sf::Mouse::getPosition(promotionWindow);
-                if (queenSprite.getGlobalBounds().contains(clickPos.x, clickPos.y)) {
-                    promotionWindow.close();
-                    return new Queen(color);
-                }
-                else if (rookSprite.getGlobalBounds().contains(clickPos.x, clickPos.y)) {
-                    promotionWindow.close();
-                    return new Rook(color);
-                }
-                else if (bishopSprite.getGlobalBounds().contains(clickPos.x, clickPos.y)) {
-                    promotionWindow.close();
-                    return new Bishop(color);
-                }
-                else if (knightSprite.getGlobalBounds().contains(clickPos.x, clickPos.y)) {
-                    promotionWindow.close();
-                    return new Knight(color);
-                }
-            }
-        }
-        promotionWindow.clear(sf::Color::White);
-        promotionWindow.draw(queenSprite);
-        promotionWindow.draw(rookSprite);
-        promotionWindow.draw(bishopSprite);
-        promotionWindow.draw(knightSprite);
-        promotionWindow.display();
-    }
-    return new Queen(color);
+bool ChessBoard::isCheckmate(Color color) {
+    return game.sideToMove() == color && game.isCheckmate();
 }
 
-bool ChessBoard::wouldBeInCheck(Piece* movingPiece, int fromX, int fromY, int toX, int toY) {
-    Piece* capturedPiece = board[toY][toX];
-    swap(board[fromY][fromX], board[toY][toX]);
-    board[fromY][fromX] = nullptr;
-
-    bool inCheck = isInCheck(movingPiece->getColor());
-
-    swap(board[fromY][fromX], board[toY][toX]);
-    board[toY][toX] = capturedPiece;
 
-    return inCheck;
+void ChessBoard::handleCheckmate(Color winningColor) {
+    winner = winningColor;
+    overlay = OVERLAY_CHECKMATE;
+    enhancer.stopClocks();
 }
 
-bool ChessBoard::willMovePreventCheck(int startX, int startY, int endX, int endY, Piece::Color color) {
-    Piece* originalDestPiece = board[endY][endX];
-    board[endY][endX] = board[startY][startX];
-    board[startY][startX] = nullptr;
-    bool inCheck = isInCheck(color);
-    board[startY][startX] = board[endY][endX];
-    board[endY][endX] = originalDestPiece;
-    return !inCheck;
-}
-
-bool ChessBoard::isCheckmate(Piece::Color color) {
-    if (!isInCheck(color)) {
-        return false;
+void ChessBoard::handleOverlayEvent(const sf::Event& event) {
+    if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape) {
+        // Backs out of the promotion, or just hides the result to look at the board.
+        overlay = OVERLAY_NONE;
+        pieceSelected = false;
+        selectedMoves.clear();
+        hintVertices.clear();
+        return;
     }
-    for (int y = 0; y < 8; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            if (board[y][x] != nullptr && board[y][x]->getColor() == color) {
-                auto validMoves = getValidMoves(x, y);
-                if (!validMoves.empty()) {
-                    return false;
-                }
+    if (event.type != sf::Event::MouseButtonPressed || event.mouseButton.button != sf::Mouse::Left)
+        return;
+    float x = static_cast<float>(event.mouseButton.x);
+    float y = static_cast<float>(event.mouseButton.y);
+    if (overlay == OVERLAY_PROMOTION) {
+        for (int i = 0; i < 4; ++i) {
+            if (promotionCell(i).contains(x, y)) {
+                overlay = OVERLAY_NONE;
+                finishMove(createMove(promotionFrom, promotionTo, PROMOTION, PROMOTION_CHOICES[i]));
+                return;
             }
         }
     }
-    return true;
+    else if (overlay == OVERLAY_CHECKMATE && RESTART_BUTTON.contains(x, y)) {
+        initBoard();
+    }
 }
 
-
-void ChessBoard::handleCheckmate(Piece::Color winningColor) {
-    string winner = (winningColor == Piece::Color::White) ? "White" : "Black";
-
-    sf::RenderWindow alertWindow(sf::VideoMode(350, 150), "Checkmate");
-    sf::Font font;
-    if (!font.loadFromFile(FONT_PATH + "arial.ttf")) {
-        cerr << "Failed to load font.\n";
+void ChessBoard::drawOverlay(sf::RenderWindow& window) {
+    if (overlay == OVERLAY_NONE)
+        return;
+    sf::RectangleShape shade(sf::Vector2f(800, 800));
+    shade.setFillColor(sf::Color(0, 0, 0, 120));
+    window.draw(shade);
+
+    if (overlay == OVERLAY_PROMOTION) {
+        sf::RectangleShape panel(sf::Vector2f(420, 120));
+        panel.setPosition(190, 340);
+        panel.setFillColor(sf::Color::White);
+        window.draw(panel);
+        sf::VertexArray choices(sf::Quads);
+        for (int i = 0; i < 4; ++i) {
+            sf::FloatRect cell = promotionCell(i);
+            atlas.appendQuad(choices, makePiece(game.sideToMove(), PROMOTION_CHOICES[i]),
+                             sf::Vector2f(cell.left + cell.width / 2, cell.top + cell.height / 2));
+        }
+        window.draw(choices, &atlas.getTexture());
+        return;
     }
 
-    sf::Text text("Checkmate! " + winner + " wins!", font, 30);
+    sf::RectangleShape panel(sf::Vector2f(350, 150));
+    panel.setPosition(225, 325);
+    panel.setFillColor(sf::Color::White);
+    window.draw(panel);
+
+    string name = (winner == WHITE) ? "White" : "Black";
+    sf::Text text("Checkmate! " + name + " wins!", font, 30);
     text.setFillColor(sf::Color::Black);
-    text.setPosition(20, 20);
+    text.setPosition(245, 345);
+    window.draw(text);
 
-    sf::RectangleShape button(sf::Vector2f(100, 50));
+    sf::RectangleShape button(sf::Vector2f(RESTART_BUTTON.width, RESTART_BUTTON.height));
     button.setFillColor(sf::Color::Blue);
-    button.setPosition(100, 80);
+    button.setPosition(RESTART_BUTTON.left, RESTART_BUTTON.top);
+    window.draw(button);
 
     sf::Text buttonText("Restart", font, 25);
     buttonText.setFillColor(sf::Color::White);
-    buttonText.setPosition(115, 90);
-
-    while (alertWindow.isOpen()) {
-        sf::Event event;
-        while (alertWindow.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) {
-                alertWindow.close();
-            }
-            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-                int mouseX = event.mouseButton.x;
-                int mouseY = event.mouseButton.y;
-                if (button.getGlobalBounds().contains(mouseX, mouseY)) {
-                    alertWindow.close();
-                    initBoard();
-                }
-            }
-        }
-        alertWindow.clear(sf::Color::White);
-        alertWindow.draw(text);
-        alertWindow.draw(button);
-        alertWindow.draw(buttonText);
-        alertWindow.display();
-    }
-
-
+    buttonText.setPosition(RESTART_BUTTON.left + 15, RESTART_BUTTON.top + 10);
+    window.draw(buttonText);
 }
 void ChessBoard::fullRestart() {
     enhancer.gameOverDueToTime = false;
@@ -413,9 +433,10 @@ void ChessBoard::fullRestart() {
     enhancer.setRestartCallback([this]() {
         fullRestart();
     });
+    enhancer.setEngineSides(engineSide[WHITE], engineSide[BLACK]);
+    enhancer.setMoveFormatter([this](size_t ply) { return historyLine(ply); });
 
     initBoard();
     pieceSelected = false;
-    moveHints.clear();
-    captureHints.clear();
+    hintVertices.clear();
 }
\ No newline at end of file
@@ -4,46 +4,103 @@
 
 #include <SFML/Graphics.hpp>
 #include <vector>
-#include "Piece.hpp"
+#include "PieceAtlas.hpp"
+#include "Game.hpp"
+#include "TranspositionTable.hpp"
+#include "EngineWorker.hpp"
+#include "Evaluate.hpp"
 #include "GameEnhancer.hpp"
 
 
 class ChessBoard {
 public:
-    ChessBoard();
-    ~ChessBoard();
+    // hashMb sizes the transposition table shared by every search of the game;
+    // threads is the number of Lazy SMP search threads.
+    explicit ChessBoard(size_t hashMb = 64, bool hugePages = false, int threads = 1);
 
     void initBoard();
     void draw(sf::RenderWindow &window);
     void handleEvent(const sf::Event &event);
+    // Starts the engine when it is its turn and plays the moves it posts back;
+    // never waits for a search. Call once per loop iteration; returns true
+    // when something on screen changed.
+    bool update();
+    // Waiting for the engine: update() may have a move to play at any time.
+    bool isThinking() const {
+        return engineRequest != 0;
+    }
     GameEnhancer& getEnhancer() {
         return enhancer;
     }
+    const Position& getPosition() const {
+        return game.getPosition();
+    }
+    // Static evaluation of the current position in centipawns, positive when
+    // White stands better.
+    int getEvaluation() const {
+        int score = evaluate(game.getPosition());
+        return game.sideToMove() == WHITE ? score : -score;
+    }
+    TranspositionTable& getTranspositionTable() {
+        return transpositionTable;
+    }
     void fullRestart();
+    // Lets the engine play from a Polyglot book; an empty path turns it off.
+    void setBook(const std::string &path, bool bestMove) {
+        engine.setBook(path, bestMove);
+    }
+    // Lets the engine probe Syzygy tablebases; an empty path turns them off.
+    void setTablebases(const std::string &paths, int maxPieces) {
+        engine.setTablebases(paths, maxPieces);
+    }
+    // Sets up a FEN position as a new game; false leaves the game untouched.
+    bool loadFen(std::string_view fen);
+    std::string getFen() const {
+        return game.getPosition().toFen();
+    }
+    // Writes the game so far as PGN; false if the file cannot be written.
+    bool savePgn(const std::string &path) const;
     // Other functions used internally:
     std::vector<sf::Vector2i> getValidMoves(int x, int y);
-    sf::Vector2i findKing(Piece::Color color);
-    bool isCheckmate(Piece::Color color);
-    bool isInCheck(Piece::Color color);
-    bool wouldBeInCheck(Piece* movingPiece, int fromX, int fromY, int toX, int toY);
-    bool willMovePreventCheck(int startX, int startY, int endX, int endY, Piece::Color color);
+    bool isCheckmate(Color color);
+    bool isInCheck(Color color);
     void highlightValidMoves(const std::vector<sf::Vector2i>& moves);
-    static void drawBoard(sf::RenderWindow &window);
+    void drawBoard(sf::RenderWindow &window);
     void drawPieces(sf::RenderWindow &window);
     void drawHints(sf::RenderWindow &window);
-    void promotePawnIfNecessary(int y, int x);
-    static Piece* choosePromotion(Piece::Color color);
-    static Piece* showPromotionDialog(Piece::Color color);
-    void handleCheckmate(Piece::Color winningColor);
+    void handleCheckmate(Color winningColor);
 
 private:
-    std::vector<std::vector<Piece*>> board; // 8x8 board of pointers
+    // Dialogs drawn over the board by the main loop; while one is open it
+    // takes all clicks.
+    enum Overlay { OVERLAY_NONE, OVERLAY_PROMOTION, OVERLAY_CHECKMATE };
+
+    void finishMove(const Move &move);
+    // History panel text of the move at ply, numbered from the start position.
+    std::string historyLine(size_t ply) const;
+    void drawOverlay(sf::RenderWindow &window);
+    void handleOverlayEvent(const sf::Event &event);
+
+    Game game; // rules and source of truth for the game state
+    TranspositionTable transpositionTable; // kept across moves, cleared for a new game
+    EngineWorker engine; // searches on its own thread
+    int engineRequest;   // id of the search we are waiting for, or 0
+    bool engineSide[2];  // colors played by the engine
+    sf::VertexArray boardVertices; // the 64 squares, built once
+    PieceAtlas atlas;
+    sf::VertexArray pieceVertices; // one quad per piece, rebuilt when the position changes
+    uint64_t pieceVerticesKey;     // position key pieceVertices was built for
     bool pieceSelected;
     sf::Vector2i selectedPiece;
-    Piece::Color currentTurn;
-    std::vector<sf::CircleShape> moveHints;
-    std::vector<sf::CircleShape> captureHints;
+    MoveList selectedMoves; // legal moves of the selected piece
+    sf::VertexArray hintVertices; // all move and capture hints, one draw call
     GameEnhancer enhancer;
+
+    Overlay overlay;
+    int promotionFrom, promotionTo; // move waiting for the promotion choice
+    Color winner;
+    // Loaded once, so opening an overlay never touches the disk.
+    sf::Font font;
 };
 
 #endif // CHESSBOARD_HPP
@@ -0,0 +1,228 @@
+#include "EngineWorker.hpp"
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+EngineWorker::EngineWorker(TranspositionTable &table) : table(table), search(table), engineThread([this]() { loop(); }) {
+    search.setInfoCallback([this](const SearchInfo &info) {
+        EngineMessage message;
+        message.type = ENGINE_INFO;
+        message.requestId = runningRequest;
+        message.info = info;
+        post(message);
+    });
+}
+
+EngineWorker::~EngineWorker() {
+    cancel();
+    Command command = {};
+    command.type = QUIT;
+    push(command);
+    engineThread.join();
+}
+
+void EngineWorker::push(Command command) {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        commands.push_back(move(command));
+    }
+    wakeUp.notify_one();
+}
+
+int EngineWorker::startSearch(const Position &pos, const vector<uint64_t> &history, const SearchLimits &limits) {
+    Command command = {};
+    command.type = SEARCH;
+    command.pos = pos;
+    command.history = history;
+    command.limits = limits;
+    int id;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        id = command.requestId = nextRequestId++;
+        commands.push_back(move(command));
+    }
+    wakeUp.notify_one();
+    return id;
+}
+
+void EngineWorker::stop() {
+    lock_guard<mutex> lock(queueMutex);
+    // Search::stop() outside a run would carry over into the next one.
+    if (runningRequest)
+        search.stop();
+}
+
+void EngineWorker::ponderhit() {
+    lock_guard<mutex> lock(queueMutex);
+    if (runningRequest)
+        search.ponderhit();
+}
+
+void EngineWorker::cancel() {
+    lock_guard<mutex> lock(queueMutex);
+    cancelledBelow = nextRequestId;
+    for (auto it = commands.begin(); it != commands.end();) {
+        if (it->type == SEARCH)
+            it = commands.erase(it);
+        else
+            ++it;
+    }
+    if (runningRequest)
+        search.stop();
+    messages.erase(remove_if(messages.begin(), messages.end(),
+                             [](const EngineMessage &message) { return message.type != ENGINE_READY; }),
+                   messages.end());
+}
+
+void EngineWorker::newGame() {
+    cancel();
+    Command command = {};
+    command.type = NEW_GAME;
+    push(command);
+}
+
+void EngineWorker::setThreads(int count) {
+    Command command = {};
+    command.type = SET_THREADS;
+    command.value = size_t(count);
+    push(command);
+}
+
+void EngineWorker::setHash(size_t megabytes, bool hugePages) {
+    Command command = {};
+    command.type = SET_HASH;
+    command.value = megabytes;
+    command.hugePages = hugePages;
+    push(command);
+}
+
+void EngineWorker::setBook(const string &path, bool bestMove) {
+    Command command = {};
+    command.type = SET_BOOK;
+    command.path = path;
+    command.value = bestMove;
+    push(command);
+}
+
+void EngineWorker::setTablebases(const string &paths, int probeLimit) {
+    Command command = {};
+    command.type = SET_TABLEBASES;
+    command.path = paths;
+    command.value = size_t(max(probeLimit, 0));
+    push(command);
+}
+
+void EngineWorker::ready() {
+    Command command = {};
+    command.type = READY;
+    push(command);
+}
+
+bool EngineWorker::poll(EngineMessage &out) {
+    lock_guard<mutex> lock(queueMutex);
+    if (messages.empty())
+        return false;
+    out = move(messages.front());
+    messages.pop_front();
+    return true;
+}
+
+bool EngineWorker::isBusy() const {
+    lock_guard<mutex> lock(queueMutex);
+    if (runningRequest)
+        return true;
+    for (const Command &command : commands) {
+        if (command.type == SEARCH)
+            return true;
+    }
+    return false;
+}
+
+void EngineWorker::post(const EngineMessage &message) {
+    // Readiness answers a request of its own, never a cancelled search.
+    bool fromSearch = message.type != ENGINE_READY;
+    if (listener) {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            if (fromSearch && message.requestId < cancelledBelow)
+                return;
+        }
+        listener(message);
+        return;
+    }
+    lock_guard<mutex> lock(queueMutex);
+    if (!fromSearch || message.requestId >= cancelledBelow)
+        messages.push_back(message);
+}
+
+void EngineWorker::loop() {
+    while (true) {
+        Command command;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            wakeUp.wait(lock, [this]() { return !commands.empty(); });
+            command = move(commands.front());
+            commands.pop_front();
+            if (command.type == SEARCH) {
+                if (command.requestId < cancelledBelow)
+                    continue;
+                // From here on cancel() and stop() reach this search.
+                runningRequest = command.requestId;
+            }
+        }
+
+        switch (command.type) {
+        case SEARCH: {
+            SearchResult result;
+            if (book.isOpen() && !command.limits.infinite && !command.limits.ponder)
+                result.bestMove = book.probe(command.pos, bookBestMove);
+            if (result.bestMove.isNone())
+                result = search.run(command.pos, command.history, command.limits);
+            EngineMessage message;
+            message.type = ENGINE_BEST_MOVE;
+            message.requestId = command.requestId;
+            message.result = result;
+            post(message);
+            // stop() and ponderhit() reach the search until here, including
+            // while a book move is played or run() has already returned.
+            lock_guard<mutex> lock(queueMutex);
+            search.clearRequests();
+            runningRequest = 0;
+            break;
+        }
+        case NEW_GAME:
+            table.clear();
+            break;
+        case SET_THREADS:
+            search.setThreads(int(command.value));
+            break;
+        case SET_HASH:
+            table.resize(command.value, command.hugePages);
+            break;
+        case SET_BOOK:
+            if (command.path.empty())
+                book.close();
+            else if (!book.open(command.path))
+                cerr << "Cannot open book " << command.path << "\n";
+            bookBestMove = command.value != 0;
+            break;
+        case SET_TABLEBASES:
+            search.setTablebases(nullptr, 0);
+            if (tablebases.init(command.path))
+                search.setTablebases(&tablebases, int(command.value));
+            else if (!command.path.empty())
+                cerr << "No tablebases found in " << command.path << "\n";
+            break;
+        case READY: {
+            EngineMessage message;
+            message.type = ENGINE_READY;
+            message.requestId = 0;
+            post(message);
+            break;
+        }
+        case QUIT:
+            return;
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef ENGINE_WORKER_HPP
+#define ENGINE_WORKER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Book.hpp"
+#include "Search.hpp"
+
+enum EngineMessageType {
+    ENGINE_INFO,      // an iteration finished; info.pv[0] is the best move so far
+    ENGINE_BEST_MOVE, // the search is over
+    ENGINE_READY      // the commands queued before ready() have been applied
+};
+
+struct EngineMessage {
+    EngineMessageType type;
+    int requestId;
+    SearchInfo info;     // ENGINE_INFO
+    SearchResult result; // ENGINE_BEST_MOVE
+};
+
+// Runs searches on a dedicated thread so the caller never blocks on one.
+// Requests are queued and answered in order; results come back either
+// through poll() on the caller's thread or, if a listener is set, directly
+// on the engine thread.
+class EngineWorker {
+public:
+    explicit EngineWorker(TranspositionTable &table);
+    ~EngineWorker();
+    EngineWorker(const EngineWorker &) = delete;
+    EngineWorker &operator=(const EngineWorker &) = delete;
+
+    // Queues a search and returns its id. history holds the keys of the
+    // positions played before pos, as for Search::run.
+    int startSearch(const Position &pos, const std::vector<uint64_t> &history, const SearchLimits &limits);
+    // Ends the running search early; its best move so far is still posted.
+    void stop();
+    // Switches a running ponder search to normal time control.
+    void ponderhit();
+    // Drops every queued and running search without posting anything more
+    // for them. Returns at once; the search unwinds within about a millisecond.
+    void cancel();
+
+    // Cancels, then clears the table on the engine thread.
+    void newGame();
+    // Applied on the engine thread once the searches queued before are done.
+    void setThreads(int count);
+    void setHash(size_t megabytes, bool hugePages = false);
+    // Plays from a Polyglot book while the position is in it, without
+    // searching; an empty path closes the book. Infinite and ponder searches
+    // always search.
+    void setBook(const std::string &path, bool bestMove = false);
+    // Probes the Syzygy tables in paths for positions of at most probeLimit
+    // pieces; an empty path turns probing off.
+    void setTablebases(const std::string &paths, int probeLimit = 7);
+    // Posts ENGINE_READY once the commands queued before it are applied.
+    // Not dropped by cancel().
+    void ready();
+
+    // Called on the engine thread for every message instead of queueing it.
+    // Set before the first search.
+    void setListener(std::function<void(const EngineMessage &)> callback) { listener = std::move(callback); }
+    // Takes the oldest posted message; false if there is none.
+    bool poll(EngineMessage &out);
+    // A search is queued or running.
+    bool isBusy() const;
+
+private:
+    enum CommandType { SEARCH, NEW_GAME, SET_THREADS, SET_HASH, SET_BOOK, SET_TABLEBASES, READY, QUIT };
+    struct Command {
+        CommandType type;
+        int requestId;
+        Position pos;
+        std::vector<uint64_t> history;
+        SearchLimits limits;
+        size_t value;
+        bool hugePages;
+        std::string path;
+    };
+
+    void loop();
+    void post(const EngineMessage &message);
+    void push(Command command);
+
+    TranspositionTable &table;
+    Search search;
+    OpeningBook book; // used on the engine thread only
+    bool bookBestMove = false;
+    Tablebases tablebases; // probed by the search threads
+    std::function<void(const EngineMessage &)> listener;
+
+    mutable std::mutex queueMutex;
+    std::condition_variable wakeUp;
+    std::deque<Command> commands;
+    std::deque<EngineMessage> messages;
+    int nextRequestId = 1;
+    int cancelledBelow = 1; // requests with smaller ids are dropped
+    int runningRequest = 0; // id of the search inside Search::run, or 0
+
+    std::thread engineThread; // last, so everything above exists when it starts
+};
+
+#endif // ENGINE_WORKER_HPP
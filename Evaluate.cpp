@@ -0,0 +1,147 @@
+#include "Evaluate.hpp"
+#include <algorithm>
+#include "Attacks.hpp"
+#include "Position.hpp"
+
+using namespace std;
+
+namespace {
+
+// Per attacked square outside the enemy pawns' reach, counted from a
+// typical number of such squares so that an average piece scores zero.
+const int MOBILITY_WEIGHT[6][2] = { { 0, 0 }, { 4, 4 }, { 5, 5 }, { 2, 4 }, { 1, 2 }, { 0, 0 } };
+const int MOBILITY_BASE[6] = { 0, 4, 6, 6, 12, 0 };
+
+const int DOUBLED_PAWN[2] = { -10, -20 };
+const int ISOLATED_PAWN[2] = { -10, -15 };
+// By rank counted from the pawn's own side. The piece-square tables already
+// pay for advancing; this is for having no pawn left to stop it.
+const int PASSED_PAWN[8][2] = { { 0, 0 }, { 2, 4 }, { 4, 8 }, { 8, 16 }, { 15, 30 }, { 25, 50 }, { 40, 80 }, { 0, 0 } };
+
+// Midgame only: pawns on the two ranks in front of a king on its back ranks,
+// and pressure on the squares around the enemy king. A lone attacker is
+// rarely dangerous, so pressure counts from two attacking pieces on.
+const int PAWN_SHIELD[2] = { 12, 6 };
+const int KING_ATTACK_WEIGHT[6] = { 0, 2, 2, 3, 5, 0 };
+const int MAX_KING_DANGER = 500;
+
+Bitboard fileBB(int file) {
+    return FILE_A << file;
+}
+
+Bitboard rankBB(int rank) {
+    return RANK_1 << (8 * rank);
+}
+
+Bitboard pawnAttacksOf(Color c, Bitboard pawns) {
+    return c == WHITE ? ((pawns & ~FILE_A) << 7) | ((pawns & ~FILE_H) << 9)
+                      : ((pawns & ~FILE_A) >> 9) | ((pawns & ~FILE_H) >> 7);
+}
+
+struct PawnMasks {
+    Bitboard adjacentFiles[8];
+    Bitboard passed[2][64]; // squares in front on the pawn's and the adjacent files
+    PawnMasks() {
+        for (int file = 0; file < 8; ++file)
+            adjacentFiles[file] = (file > 0 ? fileBB(file - 1) : 0) | (file < 7 ? fileBB(file + 1) : 0);
+        for (int sq = 0; sq < 64; ++sq) {
+            Bitboard files = adjacentFiles[fileOf(sq)] | fileBB(fileOf(sq));
+            passed[WHITE][sq] = passed[BLACK][sq] = 0;
+            for (int rank = rankOf(sq) + 1; rank < 8; ++rank)
+                passed[WHITE][sq] |= files & rankBB(rank);
+            for (int rank = rankOf(sq) - 1; rank >= 0; --rank)
+                passed[BLACK][sq] |= files & rankBB(rank);
+        }
+    }
+};
+
+const PawnMasks pawnMasks;
+
+void evaluatePawns(const Position &pos, Color us, int score[2]) {
+    Bitboard ours = pos.piecesOf(us, PAWN);
+    Bitboard theirs = pos.piecesOf(~us, PAWN);
+    for (int file = 0; file < 8; ++file) {
+        int count = popCount(ours & fileBB(file));
+        if (count == 0)
+            continue;
+        if (count > 1) {
+            score[MIDGAME] += DOUBLED_PAWN[MIDGAME] * (count - 1);
+            score[ENDGAME] += DOUBLED_PAWN[ENDGAME] * (count - 1);
+        }
+        if (!(ours & pawnMasks.adjacentFiles[file])) {
+            score[MIDGAME] += ISOLATED_PAWN[MIDGAME] * count;
+            score[ENDGAME] += ISOLATED_PAWN[ENDGAME] * count;
+        }
+    }
+    for (Bitboard b = ours; b; ) {
+        int sq = popLsb(b);
+        if (theirs & pawnMasks.passed[us][sq])
+            continue;
+        // A doubled pawn behind a passer is not passed itself.
+        if (ours & pawnMasks.passed[us][sq] & fileBB(fileOf(sq)))
+            continue;
+        int rank = us == WHITE ? rankOf(sq) : 7 - rankOf(sq);
+        score[MIDGAME] += PASSED_PAWN[rank][MIDGAME];
+        score[ENDGAME] += PASSED_PAWN[rank][ENDGAME];
+    }
+}
+
+// Mobility of us and our pressure on the enemy king.
+void evaluatePieces(const Position &pos, Color us, int score[2]) {
+    Color them = ~us;
+    Bitboard occupied = pos.all();
+    Bitboard area = ~pos.occupied[us] & ~pawnAttacksOf(them, pos.piecesOf(them, PAWN));
+    int theirKing = pos.kingSquare[them];
+    Bitboard kingZone = kingAttacks(theirKing) | squareBB(theirKing);
+    int attackers = 0, attackWeight = 0;
+
+    for (int type = KNIGHT; type <= QUEEN; ++type) {
+        for (Bitboard b = pos.piecesOf(us, PieceType(type)); b; ) {
+            int sq = popLsb(b);
+            Bitboard attacks = type == KNIGHT ? knightAttacks(sq)
+                             : type == BISHOP ? bishopAttacks(sq, occupied)
+                             : type == ROOK ? rookAttacks(sq, occupied)
+                             : bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+            int moves = popCount(attacks & area) - MOBILITY_BASE[type];
+            score[MIDGAME] += MOBILITY_WEIGHT[type][MIDGAME] * moves;
+            score[ENDGAME] += MOBILITY_WEIGHT[type][ENDGAME] * moves;
+            if (attacks & kingZone) {
+                ++attackers;
+                attackWeight += KING_ATTACK_WEIGHT[type] * popCount(attacks & kingZone);
+            }
+        }
+    }
+    if (attackers >= 2)
+        score[MIDGAME] += min(attackWeight * attackWeight / 4, MAX_KING_DANGER);
+}
+
+void evaluateShield(const Position &pos, Color us, int score[2]) {
+    int king = pos.kingSquare[us];
+    int rank = us == WHITE ? rankOf(king) : 7 - rankOf(king);
+    if (rank > 1)
+        return;
+    Bitboard files = pawnMasks.adjacentFiles[fileOf(king)] | fileBB(fileOf(king));
+    Bitboard pawns = pos.piecesOf(us, PAWN) & files;
+    int step = us == WHITE ? 1 : -1;
+    for (int i = 0; i < 2; ++i)
+        score[MIDGAME] += PAWN_SHIELD[i] * popCount(pawns & rankBB(rankOf(king) + step * (i + 1)));
+}
+
+}
+
+int evaluate(const Position &pos) {
+    int score[2] = { pos.psq[MIDGAME], pos.psq[ENDGAME] };
+    for (Color c : { WHITE, BLACK }) {
+        int side[2] = { 0, 0 };
+        evaluatePawns(pos, c, side);
+        evaluatePieces(pos, c, side);
+        evaluateShield(pos, c, side);
+        int sign = c == WHITE ? 1 : -1;
+        score[MIDGAME] += sign * side[MIDGAME];
+        score[ENDGAME] += sign * side[ENDGAME];
+    }
+    // Promotions can push the phase past the start position's.
+    int phase = min<int>(pos.phase, PHASE_MAX);
+    int blended = (score[MIDGAME] * phase + score[ENDGAME] * (PHASE_MAX - phase)) / PHASE_MAX;
+    return pos.sideToMove == WHITE ? blended : -blended;
+}
@@ -0,0 +1,111 @@
+#include "Game.hpp"
+#include <algorithm>
+#include "Notation.hpp"
+
+using namespace std;
+
+Game::Game() {
+    reset();
+}
+
+void Game::reset() {
+    position.setStartPosition();
+    startPosition = position;
+    moves.clear();
+    undoLog.clear();
+    keyHistory.clear();
+}
+
+bool Game::reset(string_view fen) {
+    Position parsed;
+    if (!parsed.setFromFen(fen))
+        return false;
+    position = parsed;
+    startPosition = parsed;
+    moves.clear();
+    undoLog.clear();
+    keyHistory.clear();
+    return true;
+}
+
+void Game::getLegalMoves(MoveList &out) const {
+    generateLegalMoves(position, out);
+}
+
+void Game::getLegalMoves(int from, MoveList &out) const {
+    MoveList all;
+    generateLegalMoves(position, all);
+    for (Move move : all) {
+        if (move.from() == from)
+            out.push_back(move);
+    }
+}
+
+bool Game::playMove(const Move &move) {
+    MoveList legal;
+    generateLegalMoves(position, legal);
+    if (!legal.contains(move))
+        return false;
+    UndoInfo undo;
+    keyHistory.push_back(position.key);
+    position.makeMove(move, undo);
+    moves.push_back(move);
+    undoLog.push_back(undo);
+    return true;
+}
+
+bool Game::undoMove() {
+    if (moves.empty())
+        return false;
+    position.unmakeMove(moves.back(), undoLog.back());
+    moves.pop_back();
+    undoLog.pop_back();
+    keyHistory.pop_back();
+    return true;
+}
+
+string Game::getSan(size_t ply) const {
+    if (ply >= moves.size())
+        return string();
+    Position pos = startPosition;
+    for (size_t i = 0; i < ply; ++i)
+        pos.makeMove(moves[i]);
+    return toSan(pos, moves[ply]);
+}
+
+Move Game::findMove(string_view uci) const {
+    if (uci.size() < 4 || uci.size() > 5)
+        return Move();
+    int from = makeSquare(uci[0] - 'a', uci[1] - '1');
+    int to = makeSquare(uci[2] - 'a', uci[3] - '1');
+    char promotion = uci.size() == 5 ? uci[4] : 0;
+    MoveList legal;
+    generateLegalMoves(position, legal);
+    for (Move move : legal) {
+        if (move.from() != from || move.to() != to)
+            continue;
+        if (move.promotion() == NO_PIECE_TYPE ? !promotion : promotion == "pnbrqk"[move.promotion()])
+            return move;
+    }
+    return Move();
+}
+
+bool Game::isInCheck() const {
+    return ::isInCheck(position, position.sideToMove);
+}
+
+bool Game::isCheckmate() const {
+    return ::isCheckmate(position);
+}
+
+bool Game::isThreefoldRepetition() const {
+    // Captures and pawn moves reset the halfmove clock and can never be undone,
+    // so only positions since then can repeat, and only every second ply.
+    int reachable = min<int>(position.halfmoveClock, int(keyHistory.size()));
+    int count = 1;
+    for (int back = 2; back <= reachable; back += 2) {
+        if (keyHistory[keyHistory.size() - back] == position.key && ++count == 3)
+            return true;
+    }
+    return false;
+}
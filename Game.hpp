@@ -0,0 +1,56 @@
+#ifndef GAME_HPP
+#define GAME_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Position.hpp"
+#include "MoveGen.hpp"
+
+// Rules-only game state: the current position plus the moves that led to it.
+// Uses plain integer squares (0 = a1 .. 63 = h8) and has no graphics dependency.
+//
+// The log keeps per ply only the 16-bit move, a 4-byte undo record and the
+// 8-byte key needed for repetitions. Text such as SAN is derived on demand.
+class Game {
+public:
+    Game();
+
+    void reset();
+    // Starts from a FEN position instead; false leaves the game untouched.
+    bool reset(std::string_view fen);
+    const Position& getPosition() const { return position; }
+    const std::vector<Move>& getMoves() const { return moves; }
+    // Position the recorded moves start from.
+    const Position& getStartPosition() const { return startPosition; }
+    // Keys of the positions before each played move, for repetition checks in search.
+    const std::vector<uint64_t>& getKeyHistory() const { return keyHistory; }
+    Color sideToMove() const { return position.sideToMove; }
+
+    void getLegalMoves(MoveList &out) const;
+    // Legal moves of the piece standing on from.
+    void getLegalMoves(int from, MoveList &out) const;
+    // Plays and records a legal move; returns false and leaves the game untouched otherwise.
+    bool playMove(const Move &move);
+    // Takes back the last move; false if there is none.
+    bool undoMove();
+    // SAN of the move played at ply (0 = first move), derived by replaying the log.
+    std::string getSan(size_t ply) const;
+    // The legal move written in UCI notation ("e2e4", "e7e8q"), or Move() if there is none.
+    Move findMove(std::string_view uci) const;
+
+    bool isInCheck() const;
+    bool isCheckmate() const;
+    // The current position occurred at least twice before with the same side to move.
+    bool isThreefoldRepetition() const;
+
+private:
+    Position startPosition;
+    Position position;
+    std::vector<Move> moves;
+    std::vector<UndoInfo> undoLog;      // one per move
+    std::vector<uint64_t> keyHistory; // Zobrist key before each played move
+};
+
+#endif // GAME_HPP
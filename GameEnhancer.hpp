@@ -2,10 +2,12 @@
 #define GAME_ENHANCER_HPP
 
 #include <SFML/Graphics.hpp>
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <chrono>
 #include <sstream>
+#include <iomanip>
 #include <iostream>
 #include <functional>
 
@@ -13,24 +15,45 @@ using namespace std;
 
 // Relative path to the font file
 const string FONT_PATH2 = "";
+// Seconds each side has for the whole game
+const float TIME_LIMIT = 180.0f;
+// Restart button of the time-over overlay
+const sf::FloatRect TIME_OVER_BUTTON(350.f, 405.f, 100.f, 40.f);
+// First rows of the move history panel, above the moves
+const string HISTORY_HEADER[2] = {"Moves History:", "----------------"};
 
 class GameEnhancer {
 private:
-    vector<string> moveHistory;
+    // The history is two header rows and one row per ply. Only the number
+    // of plies is kept; drawing asks moveFormatter for the visible rows.
+    size_t historyPlies = 0;
+    std::function<string(size_t)> moveFormatter; // row text of a ply
     chrono::time_point<chrono::steady_clock> whiteStartTime;
     chrono::time_point<chrono::steady_clock> blackStartTime;
 
     float whiteElapsed = 0.0f;
     float blackElapsed = 0.0f;
     bool isWhiteTurn = true;
+    bool clocksStopped = false; // the game is decided; both clocks are frozen
+    int drawnWhiteSeconds = -1; // clock values in the last drawn frame
+    int drawnBlackSeconds = -1;
 
     sf::Font font;
     sf::Text whiteTimerText;
     sf::Text blackTimerText;
-    sf::Text historyText;
+    sf::Text historyText; // style of the history rows
+    sf::Text engineText;
+    sf::Text evalText;
+    int shownEvaluation = 1 << 30; // centipawns in evalText
+    string engineSides = "off";
+    string engineInfo;
 
     std::function<void()> restartCallback;
 
+    // Time-over overlay, drawn over the board instead of a separate window
+    bool timeOverVisible = false;
+    string timeOverLoser;
+
     // Scrolling logic variables
     float scrollOffset = 0.0f;
     float LINE_HEIGHT = 24.0f;
@@ -58,12 +81,20 @@ public:
         blackTimerText.setFillColor(sf::Color::White);
         historyText.setFillColor(sf::Color(200, 200, 200)); // Light grey for history
 
+        engineText.setFont(font);
+        engineText.setCharacterSize(16);
+        engineText.setFillColor(sf::Color(200, 200, 200));
+        engineText.setPosition(820, 92);
+        setEngineSides(false, false);
+
+        evalText.setFont(font);
+        evalText.setCharacterSize(22);
+        evalText.setFillColor(sf::Color::White);
+        evalText.setPosition(1040, 20);
+
         whiteTimerText.setPosition(820, 20);
         blackTimerText.setPosition(820, 60);
 
-        // Initial history text position (managed by View later)
-        historyText.setPosition(820, 0);
-
         whiteStartTime = chrono::steady_clock::now();
     }
 
@@ -71,9 +102,56 @@ public:
         restartCallback = callback;
     }
 
+    // Shows which colors the engine plays; W and B toggle them
+    void setEngineSides(bool white, bool black) {
+        engineSides = white && black ? "both" : white ? "White" : black ? "Black" : "off";
+        updateEngineText();
+    }
+
+    // What the engine is thinking about; empty while it is idle
+    void setEngineInfo(const string& info) {
+        engineInfo = info;
+        updateEngineText();
+    }
+
+    // Static evaluation of the position, in centipawns for White
+    void setEvaluation(int centipawns) {
+        if (centipawns == shownEvaluation)
+            return;
+        shownEvaluation = centipawns;
+        stringstream ss;
+        ss << "Eval: " << showpos << fixed << setprecision(2) << centipawns / 100.0;
+        evalText.setString(ss.str());
+    }
+
+    void updateEngineText() {
+        string text = "Engine: " + engineSides + " (W/B to toggle)";
+        if (!engineInfo.empty())
+            text += "   " + engineInfo;
+        engineText.setString(text);
+    }
+
+    // Seconds left on the clock of the given side, counting the running turn
+    float getRemainingSeconds(bool white) const {
+        float elapsed = white ? whiteElapsed : blackElapsed;
+        if (white == isWhiteTurn && !clocksStopped)
+            elapsed += chrono::duration<float>(chrono::steady_clock::now() - (white ? whiteStartTime : blackStartTime)).count();
+        return elapsed < TIME_LIMIT ? TIME_LIMIT - elapsed : 0.0f;
+    }
+
+    // The game log lives with the caller; the panel asks it for the text of a ply
+    void setMoveFormatter(const std::function<string(size_t)>& formatter) {
+        moveFormatter = formatter;
+    }
+
+    // Header rows plus one row per ply
+    size_t historyRowCount() const {
+        return 2 + historyPlies;
+    }
+
     // Method to handle mouse wheel scrolling
     void handleScroll(float delta) {
-        float totalHeight = (moveHistory.size() + 2) * LINE_HEIGHT;
+        float totalHeight = historyRowCount() * LINE_HEIGHT;
 
         // Only scroll if history content exceeds view height
         if (totalHeight > VIEW_HEIGHT) {
@@ -85,52 +163,110 @@ public:
         }
     }
 
-    void recordMove(int fromX, int fromY, int toX, int toY) {
-        // Convert coordinates to algebraic notation
-        string move = string(1, 'a' + fromX) + to_string(8 - fromY) + " -> " +
-                      string(1, 'a' + toX) + to_string(8 - toY);
-        moveHistory.push_back(move);
+    // A move was played; its row is formatted when shown
+    void recordMove() {
+        ++historyPlies;
+        switchClock();
 
+        // Auto-scroll to the bottom when a new move is recorded
+        float totalHeight = historyRowCount() * LINE_HEIGHT;
+        if (totalHeight > VIEW_HEIGHT) {
+            scrollOffset = totalHeight - VIEW_HEIGHT;
+        }
+    }
+
+    // The last move was taken back
+    void undoMove() {
+        if (historyPlies == 0)
+            return;
+        --historyPlies;
+        switchClock();
+        float totalHeight = historyRowCount() * LINE_HEIGHT;
+        scrollOffset = totalHeight > VIEW_HEIGHT ? totalHeight - VIEW_HEIGHT : 0.0f;
+    }
+
+    // Charges the running turn to its side and starts the other clock
+    void switchClock() {
         auto now = chrono::steady_clock::now();
         if (isWhiteTurn) {
-            whiteElapsed += chrono::duration<float>(now - whiteStartTime).count();
+            if (!clocksStopped)
+                whiteElapsed += chrono::duration<float>(now - whiteStartTime).count();
             blackStartTime = now;
         } else {
-            blackElapsed += chrono::duration<float>(now - blackStartTime).count();
+            if (!clocksStopped)
+                blackElapsed += chrono::duration<float>(now - blackStartTime).count();
             whiteStartTime = now;
         }
         isWhiteTurn = !isWhiteTurn;
+    }
 
-        // Auto-scroll to the bottom when a new move is recorded
-        float totalHeight = (moveHistory.size() + 2) * LINE_HEIGHT;
-        if (totalHeight > VIEW_HEIGHT) {
-            scrollOffset = totalHeight - VIEW_HEIGHT;
-        }
+    // Freezes both clocks once the game is decided
+    void stopClocks() {
+        if (clocksStopped)
+            return;
+        currentTimes(whiteElapsed, blackElapsed);
+        clocksStopped = true;
     }
 
-    void drawExtras(sf::RenderWindow& window) {
-        // Calculate current timer values
-        float wTime = whiteElapsed;
-        float bTime = blackElapsed;
+    // Restarts the clock of the side to move, e.g. after taking back a mate
+    void resumeClocks() {
+        if (!clocksStopped)
+            return;
+        clocksStopped = false;
+        (isWhiteTurn ? whiteStartTime : blackStartTime) = chrono::steady_clock::now();
+    }
+
+    bool clocksRunning() const {
+        return !clocksStopped;
+    }
+
+    // Both clocks including the running turn
+    void currentTimes(float& wTime, float& bTime) const {
+        wTime = whiteElapsed;
+        bTime = blackElapsed;
+        if (clocksStopped)
+            return;
         auto now = chrono::steady_clock::now();
         if (isWhiteTurn) wTime += chrono::duration<float>(now - whiteStartTime).count();
         else bTime += chrono::duration<float>(now - blackStartTime).count();
+    }
 
-        // Check for timeout (180s = 3 minutes)
-        if ((wTime > 180 || bTime > 180) && !timeAlertShown) {
+    // True when the clocks show other seconds than in the last drawn frame,
+    // or a flag has just fallen
+    bool needsRedraw() const {
+        float wTime, bTime;
+        currentTimes(wTime, bTime);
+        if (!timeAlertShown && (wTime > TIME_LIMIT || bTime > TIME_LIMIT))
+            return true;
+        return static_cast<int>(wTime) != drawnWhiteSeconds || static_cast<int>(bTime) != drawnBlackSeconds;
+    }
+
+    void drawExtras(sf::RenderWindow& window) {
+        // Calculate current timer values
+        float wTime, bTime;
+        currentTimes(wTime, bTime);
+
+        // Check for timeout
+        if ((wTime > TIME_LIMIT || bTime > TIME_LIMIT) && !timeAlertShown) {
             gameOverDueToTime = true;
-            showTimeOverDialog((wTime > 180) ? "White" : "Black");
+            timeOverLoser = (wTime > TIME_LIMIT) ? "White" : "Black";
+            timeOverVisible = true;
             timeAlertShown = true;
+            stopClocks();
         }
 
+        drawnWhiteSeconds = static_cast<int>(wTime);
+        drawnBlackSeconds = static_cast<int>(bTime);
         stringstream wss, bss;
-        wss << "White Time: " << static_cast<int>(wTime) << "s";
-        bss << "Black Time: " << static_cast<int>(bTime) << "s";
+        wss << "White Time: " << drawnWhiteSeconds << "s";
+        bss << "Black Time: " << drawnBlackSeconds << "s";
         whiteTimerText.setString(wss.str());
         blackTimerText.setString(bss.str());
 
         window.draw(whiteTimerText);
         window.draw(blackTimerText);
+        window.draw(engineText);
+        window.draw(evalText);
 
 
 
@@ -145,22 +281,25 @@ public:
         historyView.setViewport(sf::FloatRect(820.f / winW, 120.f / winH, 350.f / winW, VIEW_HEIGHT / winH));
         window.setView(historyView);
 
-        stringstream hist;
-        hist << "Moves History:\n----------------\n";
-        for (size_t i = 0; i < moveHistory.size(); ++i) {
-            hist << i + 1 << ". " << moveHistory[i] << "\n";
+        // Only the rows inside the View are built and drawn, however long the game.
+        // Rows sit at fixed positions inside the View, so scrolling only moves the View.
+        size_t first = static_cast<size_t>(scrollOffset / LINE_HEIGHT);
+        size_t last = min(historyRowCount(), static_cast<size_t>((scrollOffset + VIEW_HEIGHT) / LINE_HEIGHT) + 1);
+        for (size_t i = first; i < last; ++i) {
+            sf::Text row = historyText;
+            if (i < 2)
+                row.setString(HISTORY_HEADER[i]);
+            else if (moveFormatter)
+                row.setString(moveFormatter(i - 2));
+            row.setPosition(0, i * LINE_HEIGHT);
+            window.draw(row);
         }
 
-        historyText.setString(hist.str());
-        // Position 0,0 relative to the current View
-        historyText.setPosition(0, 0);
-        window.draw(historyText);
-
         //  RESET to default view to draw the scrollbar fixed on screen
         window.setView(window.getDefaultView());
 
 
-        float totalHeight = (moveHistory.size() + 2) * LINE_HEIGHT;
+        float totalHeight = historyRowCount() * LINE_HEIGHT;
         if (totalHeight > VIEW_HEIGHT) {
             // Scrollbar track (background)
             sf::RectangleShape track(sf::Vector2f(4, VIEW_HEIGHT));
@@ -176,52 +315,70 @@ public:
             scrollbar.setFillColor(sf::Color(180, 180, 180));
             window.draw(scrollbar);
         }
+
+        if (timeOverVisible)
+            drawTimeOver(window);
     }
 
-    void showTimeOverDialog(const string& loserColor) {
-        sf::RenderWindow timeoutWindow(sf::VideoMode(320, 150), "Time's up!");
-        sf::Text message("Time's up! " + loserColor + " lost.", font, 24);
+    // "White" or "Black" once a flag has fallen
+    const string& getTimeOverLoser() const {
+        return timeOverLoser;
+    }
+
+    // Clicks and keys for the time-over overlay; true when it took the event
+    bool handleEvent(const sf::Event& event) {
+        if (!timeOverVisible)
+            return false;
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape) {
+            timeOverVisible = false; // keep looking at the final position
+        }
+        else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left
+                 && TIME_OVER_BUTTON.contains((float)event.mouseButton.x, (float)event.mouseButton.y)) {
+            reset();
+            if (restartCallback) restartCallback();
+        }
+        return true;
+    }
+
+    void drawTimeOver(sf::RenderWindow& window) {
+        sf::RectangleShape shade(sf::Vector2f(800, 800));
+        shade.setFillColor(sf::Color(0, 0, 0, 120));
+        window.draw(shade);
+
+        sf::RectangleShape panel(sf::Vector2f(320, 150));
+        panel.setPosition(240, 325);
+        panel.setFillColor(sf::Color::White);
+        window.draw(panel);
+
+        sf::Text message("Time's up! " + timeOverLoser + " lost.", font, 24);
         message.setFillColor(sf::Color::Black);
-        message.setPosition(20, 20);
+        message.setPosition(260, 345);
+        window.draw(message);
 
-        sf::RectangleShape button(sf::Vector2f(100, 40));
+        sf::RectangleShape button(sf::Vector2f(TIME_OVER_BUTTON.width, TIME_OVER_BUTTON.height));
         button.setFillColor(sf::Color::Blue);
-        button.setPosition(110, 80);
+        button.setPosition(TIME_OVER_BUTTON.left, TIME_OVER_BUTTON.top);
+        window.draw(button);
 
         sf::Text buttonText("Restart", font, 20);
         buttonText.setFillColor(sf::Color::White);
-        buttonText.setPosition(122, 88);
-
-        while (timeoutWindow.isOpen()) {
-            sf::Event event;
-            while (timeoutWindow.pollEvent(event)) {
-                if (event.type == sf::Event::Closed) timeoutWindow.close();
-                if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-                    if (button.getGlobalBounds().contains((float)event.mouseButton.x, (float)event.mouseButton.y)) {
-                        timeoutWindow.close();
-                        reset();
-                        if (restartCallback) restartCallback();
-                    }
-                }
-            }
-            timeoutWindow.clear(sf::Color::White);
-            timeoutWindow.draw(message);
-            timeoutWindow.draw(button);
-            timeoutWindow.draw(buttonText);
-            timeoutWindow.display();
-        }
+        buttonText.setPosition(TIME_OVER_BUTTON.left + 12, TIME_OVER_BUTTON.top + 8);
+        window.draw(buttonText);
     }
 
-    void reset() {
+    // Clears clocks and history; whiteToMove says whose clock starts
+    void reset(bool whiteToMove = true) {
         gameOverDueToTime = false;
         timeAlertShown = false;
+        timeOverVisible = false;
         whiteElapsed = 0.0f;
         blackElapsed = 0.0f;
         scrollOffset = 0.0f;
-        moveHistory.clear();
+        historyPlies = 0;
         whiteStartTime = chrono::steady_clock::now();
         blackStartTime = chrono::steady_clock::now();
-        isWhiteTurn = true;
+        isWhiteTurn = whiteToMove;
+        clocksStopped = false;
     }
 };
 
@@ -0,0 +1,129 @@
+#include "MappedFile.hpp"
+#include <fstream>
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define MAPPED_FILE_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+using namespace std;
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const string &path) {
+    close();
+#if defined(MAPPED_FILE_POSIX)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    length = size_t(info.st_size);
+    if (length > 0) {
+        void *memory = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (memory == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        bytes = static_cast<const char *>(memory);
+        mapped = true;
+    }
+    // The mapping keeps the file alive on its own.
+    ::close(fd);
+#elif defined(MAPPED_FILE_WINDOWS)
+    HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+    length = size_t(fileSize.QuadPart);
+    // Windows cannot map an empty file; it simply has no bytes.
+    if (length > 0) {
+        HANDLE mapping = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void *memory = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (mapping)
+            CloseHandle(mapping);
+        if (!memory) {
+            CloseHandle(fileHandle);
+            length = 0;
+            return false;
+        }
+        bytes = static_cast<const char *>(memory);
+        mapped = true;
+    }
+    // The view keeps the file alive on its own.
+    CloseHandle(fileHandle);
+#else
+    ifstream in(path, ios::binary);
+    if (!in)
+        return false;
+    buffer.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    length = buffer.size();
+    bytes = length ? buffer.data() : nullptr;
+#endif
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+#if defined(MAPPED_FILE_POSIX)
+    if (mapped)
+        munmap(const_cast<char *>(bytes), length);
+#elif defined(MAPPED_FILE_WINDOWS)
+    if (mapped)
+        UnmapViewOfFile(bytes);
+#endif
+    buffer.clear();
+    buffer.shrink_to_fit();
+    bytes = nullptr;
+    length = 0;
+    opened = false;
+    mapped = false;
+}
+
+void MappedFile::adviseSequential() const {
+#if defined(MAPPED_FILE_POSIX)
+    if (mapped)
+        madvise(const_cast<char *>(bytes), length, MADV_SEQUENTIAL);
+#endif
+}
+
+void MappedFile::adviseRandom() const {
+#if defined(MAPPED_FILE_POSIX)
+    if (mapped)
+        madvise(const_cast<char *>(bytes), length, MADV_RANDOM);
+#endif
+}
+
+void MappedFile::release(size_t begin, size_t end) const {
+#if defined(MAPPED_FILE_POSIX)
+    // madvise works on whole pages.
+    size_t page = size_t(sysconf(_SC_PAGESIZE));
+    begin = (begin + page - 1) / page * page;
+    end = end < length ? end - end % page : length;
+    if (mapped && begin < end)
+        madvise(const_cast<char *>(bytes) + begin, end - begin, MADV_DONTNEED);
+#else
+    // Windows trims clean file pages from the working set under pressure.
+    (void)begin;
+    (void)end;
+#endif
+}
@@ -0,0 +1,42 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A whole file mapped read-only into memory. The kernel pages it in on
+// access, so opening a multi-gigabyte file costs nothing and only the parts
+// actually touched occupy RAM. Uses mmap on POSIX systems and a file view
+// on Windows; elsewhere the file is read into a buffer instead.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Maps path, replacing any file mapped before. Returns false if it cannot be read.
+    bool open(const std::string &path);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const char *data() const { return bytes; }
+    size_t size() const { return length; }
+
+    // Access hints: sequential scans read ahead, random probes do not.
+    void adviseSequential() const;
+    void adviseRandom() const;
+    // Drops the whole pages inside [begin, end) from this process; they are
+    // read again from the file if touched later. Keeps memory bounded while streaming.
+    void release(size_t begin, size_t end) const;
+
+private:
+    const char *bytes = nullptr;
+    size_t length = 0;
+    bool opened = false;
+    bool mapped = false;
+    std::vector<char> buffer; // fallback storage when not mapped
+};
+
+#endif // MAPPED_FILE_HPP
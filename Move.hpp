@@ -0,0 +1,87 @@
+#ifndef MOVE_HPP
+#define MOVE_HPP
+
+#include <cstdint>
+#include <string>
+#include "Bitboard.hpp"
+
+enum MoveType : uint16_t {
+    NORMAL     = 0,
+    PROMOTION  = 1 << 14,
+    EN_PASSANT = 2 << 14,
+    CASTLING   = 3 << 14
+};
+
+// A move packed into 16 bits:
+// bits 0-5 from square, 6-11 to square, 12-13 promotion piece (knight..queen), 14-15 MoveType.
+class Move {
+public:
+    // Left uninitialized so a MoveList costs nothing to create; Move() is zero.
+    Move() = default;
+    explicit Move(uint16_t raw) : data(raw) {}
+
+    int from() const { return data & 0x3F; }
+    int to() const { return (data >> 6) & 0x3F; }
+    MoveType type() const { return MoveType(data & (3 << 14)); }
+    PieceType promotion() const {
+        return type() == PROMOTION ? PieceType(((data >> 12) & 3) + KNIGHT) : NO_PIECE_TYPE;
+    }
+    uint16_t raw() const { return data; }
+    // Move() encodes a1a1, which is never legal, so it doubles as "no move".
+    bool isNone() const { return data == 0; }
+
+    bool operator==(const Move &other) const { return data == other.data; }
+    bool operator!=(const Move &other) const { return data != other.data; }
+
+private:
+    uint16_t data;
+};
+
+inline Move createMove(int from, int to, MoveType type = NORMAL, PieceType promotion = KNIGHT) {
+    return Move(uint16_t(from | to << 6 | (type == PROMOTION ? (promotion - KNIGHT) << 12 : 0) | type));
+}
+
+// Fixed-capacity move buffer that lives on the stack. 256 is above the
+// largest known number of legal moves in any position (218).
+class MoveList {
+public:
+    static const int CAPACITY = 256;
+
+    void push_back(Move move) { moves[count++] = move; }
+    void clear() { count = 0; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Move &operator[](int i) { return moves[i]; }
+    const Move &operator[](int i) const { return moves[i]; }
+    Move *begin() { return moves; }
+    Move *end() { return moves + count; }
+    const Move *begin() const { return moves; }
+    const Move *end() const { return moves + count; }
+
+    bool contains(Move move) const {
+        for (int i = 0; i < count; ++i) {
+            if (moves[i] == move)
+                return true;
+        }
+        return false;
+    }
+
+private:
+    Move moves[CAPACITY];
+    int count = 0;
+};
+
+// Coordinate notation used by UCI, e.g. "e2e4" or "e7e8q".
+inline std::string toUciString(const Move &move) {
+    std::string text;
+    text += char('a' + fileOf(move.from()));
+    text += char('1' + rankOf(move.from()));
+    text += char('a' + fileOf(move.to()));
+    text += char('1' + rankOf(move.to()));
+    if (move.promotion() != NO_PIECE_TYPE)
+        text += "pnbrqk"[move.promotion()];
+    return text;
+}
+
+#endif // MOVE_HPP
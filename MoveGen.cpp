@@ -0,0 +1,223 @@
+#include "MoveGen.hpp"
+
+using namespace std;
+
+namespace {
+
+void addMoves(int from, Bitboard targets, MoveList &moves) {
+    while (targets)
+        moves.push_back(createMove(from, popLsb(targets)));
+}
+
+void addPawnMove(int from, int to, MoveList &moves) {
+    if (rankOf(to) == 0 || rankOf(to) == 7) {
+        moves.push_back(createMove(from, to, PROMOTION, QUEEN));
+        moves.push_back(createMove(from, to, PROMOTION, ROOK));
+        moves.push_back(createMove(from, to, PROMOTION, BISHOP));
+        moves.push_back(createMove(from, to, PROMOTION, KNIGHT));
+    } else {
+        moves.push_back(createMove(from, to));
+    }
+}
+
+void generateCastling(const Position &pos, MoveList &moves) {
+    Color us = pos.sideToMove;
+    uint8_t kingside = us == WHITE ? WHITE_OO : BLACK_OO;
+    uint8_t queenside = us == WHITE ? WHITE_OOO : BLACK_OOO;
+    if (!(pos.castling & (kingside | queenside)))
+        return;
+
+    // Only called when not in check, so the king's own square is safe.
+    int kingSq = makeSquare(4, us == WHITE ? 0 : 7);
+    Bitboard rooks = pos.piecesOf(us, ROOK);
+    if (pos.kingSquare[us] != kingSq)
+        return;
+
+    // The king may not pass over or land on an attacked square.
+    if ((pos.castling & kingside) && (rooks & squareBB(kingSq + 3))
+        && !(pos.all() & (squareBB(kingSq + 1) | squareBB(kingSq + 2)))
+        && !isSquareAttacked(pos, kingSq + 1, ~us) && !isSquareAttacked(pos, kingSq + 2, ~us))
+        moves.push_back(createMove(kingSq, kingSq + 2, CASTLING));
+    if ((pos.castling & queenside) && (rooks & squareBB(kingSq - 4))
+        && !(pos.all() & (squareBB(kingSq - 1) | squareBB(kingSq - 2) | squareBB(kingSq - 3)))
+        && !isSquareAttacked(pos, kingSq - 1, ~us) && !isSquareAttacked(pos, kingSq - 2, ~us))
+        moves.push_back(createMove(kingSq, kingSq - 2, CASTLING));
+}
+
+// Own pieces that are the only blocker between the king and an enemy slider.
+Bitboard pinnedPieces(const Position &pos, Color us) {
+    Color them = ~us;
+    int kingSq = pos.kingSquare[us];
+    Bitboard queens = pos.piecesOf(them, QUEEN);
+    Bitboard snipers = (rookAttacks(kingSq, 0) & (pos.piecesOf(them, ROOK) | queens))
+                       | (bishopAttacks(kingSq, 0) & (pos.piecesOf(them, BISHOP) | queens));
+    Bitboard pinned = 0;
+    while (snipers) {
+        Bitboard blockers = betweenBB(kingSq, popLsb(snipers)) & pos.all();
+        if (blockers && !(blockers & (blockers - 1)))
+            pinned |= blockers & pos.occupied[us];
+    }
+    return pinned;
+}
+
+// En passant removes two pieces from one rank, which pin detection cannot
+// see, so replay the occupancy change and look for attackers on the king.
+bool isEnPassantLegal(const Position &pos, int from, int to) {
+    Color us = pos.sideToMove;
+    int capturedSq = us == WHITE ? to - 8 : to + 8;
+    Bitboard occ = (pos.all() ^ squareBB(from) ^ squareBB(capturedSq)) | squareBB(to);
+    return !(attackersTo(pos, pos.kingSquare[us], occ) & pos.occupied[~us] & ~squareBB(capturedSq));
+}
+
+}
+
+Bitboard attackersTo(const Position &pos, int sq, Bitboard occupied) {
+    Bitboard rooksQueens = pos.pieces[W_ROOK] | pos.pieces[B_ROOK] | pos.pieces[W_QUEEN] | pos.pieces[B_QUEEN];
+    Bitboard bishopsQueens = pos.pieces[W_BISHOP] | pos.pieces[B_BISHOP] | pos.pieces[W_QUEEN] | pos.pieces[B_QUEEN];
+    return (pawnAttacks(BLACK, sq) & pos.pieces[W_PAWN])
+           | (pawnAttacks(WHITE, sq) & pos.pieces[B_PAWN])
+           | (knightAttacks(sq) & (pos.pieces[W_KNIGHT] | pos.pieces[B_KNIGHT]))
+           | (kingAttacks(sq) & (pos.pieces[W_KING] | pos.pieces[B_KING]))
+           | (rookAttacks(sq, occupied) & rooksQueens)
+           | (bishopAttacks(sq, occupied) & bishopsQueens);
+}
+
+bool isSquareAttacked(const Position &pos, int sq, Color by) {
+    // Look outward from sq: a piece attacks sq exactly when the same piece
+    // type standing on sq would attack it.
+    Bitboard occ = pos.all();
+    Bitboard queens = pos.piecesOf(by, QUEEN);
+    return (pawnAttacks(~by, sq) & pos.piecesOf(by, PAWN))
+           || (knightAttacks(sq) & pos.piecesOf(by, KNIGHT))
+           || (kingAttacks(sq) & pos.piecesOf(by, KING))
+           || (bishopAttacks(sq, occ) & (pos.piecesOf(by, BISHOP) | queens))
+           || (rookAttacks(sq, occ) & (pos.piecesOf(by, ROOK) | queens));
+}
+
+bool isInCheck(const Position &pos, Color c) {
+    return isSquareAttacked(pos, pos.kingSquare[c], ~c);
+}
+
+void generateLegalMoves(const Position &pos, MoveList &moves) {
+    Color us = pos.sideToMove;
+    Bitboard own = pos.occupied[us];
+    Bitboard enemies = pos.occupied[~us];
+    Bitboard occ = pos.all();
+    int kingSq = pos.kingSquare[us];
+    Bitboard checkers = attackersTo(pos, kingSq, occ) & enemies;
+
+    // King steps are tested with the king lifted off the board, so a slider
+    // checking along a line still covers the square behind the king.
+    Bitboard kingless = occ ^ squareBB(kingSq);
+    for (Bitboard b = kingAttacks(kingSq) & ~own; b; ) {
+        int to = popLsb(b);
+        if (!(attackersTo(pos, to, kingless) & enemies))
+            moves.push_back(createMove(kingSq, to));
+    }
+    // In double check only the king can move.
+    if (checkers & (checkers - 1))
+        return;
+
+    // Other pieces must capture the checker or block its line, and pinned
+    // pieces must stay on the line through their king.
+    Bitboard evasion = checkers ? betweenBB(kingSq, lsb(checkers)) | checkers : ~0ULL;
+    Bitboard pinned = pinnedPieces(pos, us);
+    int forward = us == WHITE ? 8 : -8;
+    Bitboard startRank = us == WHITE ? RANK_2 : RANK_7;
+
+    for (Bitboard b = pos.piecesOf(us, PAWN); b; ) {
+        int from = popLsb(b);
+        Bitboard allowed = (pinned & squareBB(from)) ? evasion & lineBB(kingSq, from) : evasion;
+        int to = from + forward;
+        if (!(occ & squareBB(to))) {
+            if (allowed & squareBB(to))
+                addPawnMove(from, to, moves);
+            if ((startRank & squareBB(from)) && !(occ & squareBB(to + forward)) && (allowed & squareBB(to + forward)))
+                moves.push_back(createMove(from, to + forward));
+        }
+        Bitboard attacks = pawnAttacks(us, from);
+        for (Bitboard caps = attacks & enemies & allowed; caps; )
+            addPawnMove(from, popLsb(caps), moves);
+        if (pos.epSquare != NO_SQUARE && (attacks & squareBB(pos.epSquare))
+            && isEnPassantLegal(pos, from, pos.epSquare))
+            moves.push_back(createMove(from, pos.epSquare, EN_PASSANT));
+    }
+
+    Bitboard targets = ~own & evasion;
+    for (int type = KNIGHT; type <= QUEEN; ++type) {
+        for (Bitboard b = pos.piecesOf(us, PieceType(type)); b; ) {
+            int from = popLsb(b);
+            Bitboard attacks;
+            switch (type) {
+                case KNIGHT: attacks = knightAttacks(from); break;
+                case BISHOP: attacks = bishopAttacks(from, occ); break;
+                case ROOK: attacks = rookAttacks(from, occ); break;
+                default: attacks = queenAttacks(from, occ); break;
+            }
+            attacks &= targets;
+            if (pinned & squareBB(from))
+                attacks &= lineBB(kingSq, from);
+            addMoves(from, attacks, moves);
+        }
+    }
+
+    if (!checkers)
+        generateCastling(pos, moves);
+}
+
+bool isCheckmate(const Position &pos) {
+    if (!isInCheck(pos, pos.sideToMove))
+        return false;
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    return moves.empty();
+}
+
+bool isLegalMove(const Position &pos, Move move) {
+    Color us = pos.sideToMove;
+    int from = move.from(), to = move.to();
+    PieceCode piece = pos.pieceOn(from);
+    if (piece == NO_PIECE || colorOf(piece) != us || (pos.occupied[us] & squareBB(to)))
+        return false;
+    if (move.type() == CASTLING) {
+        MoveList moves;
+        generateLegalMoves(pos, moves);
+        return moves.contains(move);
+    }
+
+    Bitboard occ = pos.all();
+    Bitboard toBB = squareBB(to);
+    PieceType type = typeOf(piece);
+    bool reachable;
+    switch (type) {
+        case PAWN: {
+            int forward = us == WHITE ? 8 : -8;
+            if (move.type() == EN_PASSANT)
+                reachable = to == pos.epSquare && (pawnAttacks(us, from) & toBB);
+            else if (pos.occupied[~us] & toBB)
+                reachable = (pawnAttacks(us, from) & toBB) != 0;
+            else
+                reachable = !(occ & toBB) && (to == from + forward
+                            || (to == from + 2 * forward && rankOf(from) == (us == WHITE ? 1 : 6)
+                                && !(occ & squareBB(from + forward))));
+            // Reaching the last rank must promote, and only then.
+            if ((move.type() == PROMOTION) != (rankOf(to) == 0 || rankOf(to) == 7))
+                return false;
+            break;
+        }
+        case KNIGHT: reachable = (knightAttacks(from) & toBB) != 0; break;
+        case BISHOP: reachable = (bishopAttacks(from, occ) & toBB) != 0; break;
+        case ROOK:   reachable = (rookAttacks(from, occ) & toBB) != 0; break;
+        case QUEEN:  reachable = (queenAttacks(from, occ) & toBB) != 0; break;
+        default:     reachable = (kingAttacks(from) & toBB) != 0; break;
+    }
+    if (!reachable || (type != PAWN && move.type() != NORMAL))
+        return false;
+    // Unused promotion bits must be clear, as in generated moves.
+    if (move.type() != PROMOTION && move != createMove(from, to, move.type()))
+        return false;
+
+    Position next = pos;
+    next.makeMove(move);
+    return !isInCheck(next, us);
+}
@@ -0,0 +1,21 @@
+#ifndef MOVEGEN_HPP
+#define MOVEGEN_HPP
+
+#include "Attacks.hpp"
+#include "Position.hpp"
+
+// Pieces of both colors attacking sq, with sliders blocked by occupied.
+Bitboard attackersTo(const Position &pos, int sq, Bitboard occupied);
+// True if any piece of color by attacks sq.
+bool isSquareAttacked(const Position &pos, int sq, Color by);
+bool isInCheck(const Position &pos, Color c);
+
+// Fully legal moves for the side to move. Pins, checkers and evasion squares
+// are computed once up front, so no move has to be tried on a board copy.
+void generateLegalMoves(const Position &pos, MoveList &moves);
+bool isCheckmate(const Position &pos);
+// True if move is one of the moves generateLegalMoves would produce. Checks
+// only the moving piece, so it is much cheaper than generating the list.
+bool isLegalMove(const Position &pos, Move move);
+
+#endif // MOVEGEN_HPP
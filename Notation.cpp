@@ -0,0 +1,181 @@
+#include "Notation.hpp"
+#include "MoveGen.hpp"
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+void appendSquare(string &text, int sq) {
+    text += char('a' + fileOf(sq));
+    text += char('1' + rankOf(sq));
+}
+
+}
+
+string toSan(const Position &pos, const Move &move) {
+    int from = move.from(), to = move.to();
+    PieceType type = typeOf(pos.pieceOn(from));
+    bool capture = move.type() == EN_PASSANT || (pos.occupied[~pos.sideToMove] & squareBB(to));
+    string san;
+
+    if (move.type() == CASTLING) {
+        san = to > from ? "O-O" : "O-O-O";
+    } else if (type == PAWN) {
+        if (capture) {
+            san += char('a' + fileOf(from));
+            san += 'x';
+        }
+        appendSquare(san, to);
+        if (move.type() == PROMOTION) {
+            san += '=';
+            san += "PNBRQK"[move.promotion()];
+        }
+    } else {
+        san += "PNBRQK"[type];
+        // Name the origin file, rank or both only if another piece of the
+        // same kind could also go there.
+        MoveList legal;
+        generateLegalMoves(pos, legal);
+        bool ambiguous = false, sameFile = false, sameRank = false;
+        for (Move other : legal) {
+            if (other.to() != to || other.from() == from || typeOf(pos.pieceOn(other.from())) != type)
+                continue;
+            ambiguous = true;
+            sameFile |= fileOf(other.from()) == fileOf(from);
+            sameRank |= rankOf(other.from()) == rankOf(from);
+        }
+        if (ambiguous && (!sameFile || sameRank))
+            san += char('a' + fileOf(from));
+        if (ambiguous && sameFile)
+            san += char('1' + rankOf(from));
+        if (capture)
+            san += 'x';
+        appendSquare(san, to);
+    }
+
+    Position next = pos;
+    next.makeMove(move);
+    if (isInCheck(next, next.sideToMove))
+        san += isCheckmate(next) ? '#' : '+';
+    return san;
+}
+
+Move parseSan(const Position &pos, string_view san) {
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?'))
+        san.remove_suffix(1);
+    if (san.size() < 2)
+        return Move();
+
+    if (san[0] == 'O' || san[0] == '0') {
+        bool kingside = san == "O-O" || san == "0-0";
+        if (!kingside && san != "O-O-O" && san != "0-0-0")
+            return Move();
+        MoveList legal;
+        generateLegalMoves(pos, legal);
+        for (Move move : legal) {
+            if (move.type() == CASTLING && (move.to() > move.from()) == kingside)
+                return move;
+        }
+        return Move();
+    }
+
+    PieceType type = PAWN;
+    const char *pieceLetters = "PNBRQK";
+    if (san[0] >= 'B' && san[0] <= 'R') {
+        const char *found = strchr(pieceLetters, san[0]);
+        if (!found)
+            return Move();
+        type = PieceType(found - pieceLetters);
+        san.remove_prefix(1);
+    }
+
+    // "e8=Q", "e8Q" or "e8(Q)" for promotions.
+    PieceType promotion = NO_PIECE_TYPE;
+    if (!san.empty() && san.back() == ')')
+        san.remove_suffix(1);
+    if (san.size() >= 3 && san.back() >= 'B' && san.back() <= 'R') {
+        const char *found = strchr(pieceLetters, san.back());
+        if (!found || type != PAWN)
+            return Move();
+        promotion = PieceType(found - pieceLetters);
+        san.remove_suffix(1);
+        if (san.back() == '=' || san.back() == '(')
+            san.remove_suffix(1);
+    }
+
+    if (san.size() < 2)
+        return Move();
+    char toFile = san[san.size() - 2], toRank = san[san.size() - 1];
+    if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8')
+        return Move();
+    int to = makeSquare(toFile - 'a', toRank - '1');
+    san.remove_suffix(2);
+
+    // What is left names the origin: file, rank or both, possibly with 'x' or '-'.
+    int fromFile = -1, fromRank = -1;
+    bool captureMark = false;
+    for (char c : san) {
+        if (c >= 'a' && c <= 'h')
+            fromFile = c - 'a';
+        else if (c >= '1' && c <= '8')
+            fromRank = c - '1';
+        else if (c == 'x' || c == ':')
+            captureMark = true;
+        else if (c != '-')
+            return Move();
+    }
+
+    // Only pieces of the named kind that reach the target square are
+    // candidates, so the full move list is never generated.
+    Color us = pos.sideToMove;
+    Bitboard toBB = squareBB(to);
+    Bitboard occ = pos.all();
+    if (pos.occupied[us] & toBB)
+        return Move();
+    Bitboard candidates = 0;
+    Bitboard pawns = pos.piecesOf(us, PAWN);
+    switch (type) {
+        case PAWN:
+            // A capture names the file it comes from ("exd5"); a bare target
+            // square is a push, which an occupied square blocks.
+            if (fromFile >= 0 && fromFile != fileOf(to)) {
+                if ((pos.occupied[~us] & toBB) || to == pos.epSquare)
+                    candidates = pawnAttacks(~us, to) & pawns;
+            } else if (!captureMark && !(occ & toBB)) {
+                int back = us == WHITE ? -8 : 8;
+                if (pawns & squareBB(to + back))
+                    candidates = squareBB(to + back);
+                else if (rankOf(to) == (us == WHITE ? 3 : 4) && !(occ & squareBB(to + back)))
+                    candidates = pawns & squareBB(to + 2 * back);
+            }
+            break;
+        case KNIGHT: candidates = knightAttacks(to) & pos.piecesOf(us, KNIGHT); break;
+        case BISHOP: candidates = bishopAttacks(to, occ) & pos.piecesOf(us, BISHOP); break;
+        case ROOK:   candidates = rookAttacks(to, occ) & pos.piecesOf(us, ROOK); break;
+        case QUEEN:  candidates = queenAttacks(to, occ) & pos.piecesOf(us, QUEEN); break;
+        default:     candidates = kingAttacks(to) & pos.piecesOf(us, KING); break;
+    }
+
+    bool lastRank = rankOf(to) == (us == WHITE ? 7 : 0);
+    if ((type == PAWN && lastRank) != (promotion != NO_PIECE_TYPE) || promotion == PAWN || promotion == KING)
+        return Move();
+
+    Move found = Move();
+    while (candidates) {
+        int from = popLsb(candidates);
+        if ((fromFile >= 0 && fileOf(from) != fromFile) || (fromRank >= 0 && rankOf(from) != fromRank))
+            continue;
+        Move move = promotion != NO_PIECE_TYPE ? createMove(from, to, PROMOTION, promotion)
+                    : type == PAWN && to == pos.epSquare ? createMove(from, to, EN_PASSANT)
+                    : createMove(from, to);
+        Position next = pos;
+        next.makeMove(move);
+        if (isInCheck(next, us))
+            continue;
+        if (!found.isNone())
+            return Move(); // ambiguous
+        found = move;
+    }
+    return found;
+}
@@ -0,0 +1,18 @@
+#ifndef NOTATION_HPP
+#define NOTATION_HPP
+
+#include <string>
+#include <string_view>
+#include "Position.hpp"
+
+// Standard Algebraic Notation of a legal move in pos: "Nbd7", "exd5",
+// "e8=Q+", "O-O#". Needs the position before the move for disambiguation
+// and the check suffix.
+std::string toSan(const Position &pos, const Move &move);
+
+// The legal move of pos written in SAN, or Move() if there is none or the
+// text fits several. Accepts the usual variants: "0-0", "e8Q", "Ng1-f3",
+// trailing check marks and annotations. Does not allocate.
+Move parseSan(const Position &pos, std::string_view san);
+
+#endif // NOTATION_HPP
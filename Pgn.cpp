@@ -0,0 +1,295 @@
+#include "Pgn.hpp"
+#include "MoveGen.hpp"
+#include "Notation.hpp"
+
+using namespace std;
+
+namespace {
+
+// Parsed pages are given back in steps of this size.
+const size_t RELEASE_STEP = 64 * 1024 * 1024;
+
+const char *const ROSTER[] = { "Event", "Site", "Date", "Round", "White", "Black" };
+const char *const ROSTER_DEFAULTS[] = { "?", "?", "????.??.??", "?", "?", "?" };
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Ends a SAN token.
+bool isDelimiter(char c) {
+    return isSpace(c) || c == '{' || c == '(' || c == ')' || c == ';';
+}
+
+// Length of the result marker starting at text, or 0 if there is none.
+size_t resultLength(string_view text) {
+    size_t length = 0;
+    if (text.substr(0, 7) == "1/2-1/2")
+        length = 7;
+    else if (text.substr(0, 3) == "1-0" || text.substr(0, 3) == "0-1")
+        length = 3;
+    else if (!text.empty() && text[0] == '*')
+        length = 1;
+    return length && (length == text.size() || isSpace(text[length]) || text[length] == ')') ? length : 0;
+}
+
+}
+
+string_view PgnGame::tag(string_view name) const {
+    for (const PgnTag &t : tags) {
+        if (t.name == name)
+            return t.value;
+    }
+    return string_view();
+}
+
+bool SanTokenizer::next(string_view &san) {
+    const char *p = rest.data(), *end = p + rest.size();
+    int depth = 0; // nesting of variations being skipped
+    while (p < end) {
+        switch (*p) {
+            case ' ': case '\t': case '\n': case '\r': case '.':
+                ++p;
+                continue;
+            case '{':
+                while (p < end && *p != '}')
+                    ++p;
+                p += p < end;
+                continue;
+            case ';':
+                while (p < end && *p != '\n')
+                    ++p;
+                continue;
+            case '(':
+                ++depth;
+                ++p;
+                continue;
+            case ')':
+                depth -= depth > 0;
+                ++p;
+                continue;
+            default:
+                break;
+        }
+        const char *start = p;
+        while (p < end && !isDelimiter(*p))
+            ++p;
+        string_view token(start, size_t(p - start));
+        if (depth > 0 || token[0] == '$')
+            continue;
+        // Move numbers, possibly glued to the move ("12.", "12...Nf6"), and results.
+        if (token[0] >= '0' && token[0] <= '9') {
+            if (resultLength(token))
+                continue;
+            size_t skip = 0;
+            while (skip < token.size() && ((token[skip] >= '0' && token[skip] <= '9') || token[skip] == '.'))
+                ++skip;
+            token.remove_prefix(skip);
+            if (token.empty())
+                continue;
+        } else if (token[0] == '*') {
+            continue;
+        }
+        rest = string_view(p, size_t(end - p));
+        san = token;
+        return true;
+    }
+    rest = string_view();
+    return false;
+}
+
+bool PgnReader::open(const string &path) {
+    setText(string_view());
+    if (!file.open(path))
+        return false;
+    file.adviseSequential();
+    text = string_view(file.data(), file.size());
+    return true;
+}
+
+void PgnReader::setText(string_view newText) {
+    file.close();
+    text = newText;
+    cursor = 0;
+    released = 0;
+}
+
+bool PgnReader::next(PgnGame &game) {
+    const char *data = text.data();
+    size_t size = text.size();
+    game.tags.clear();
+    game.movetext = string_view();
+    game.result = string_view();
+
+    if (file.isOpen() && cursor - released >= RELEASE_STEP) {
+        file.release(released, cursor);
+        released = cursor;
+    }
+
+    // Tag pairs, each on its own line; '%' lines are escaped and ignored.
+    size_t i = cursor;
+    for (;;) {
+        while (i < size && isSpace(data[i]))
+            ++i;
+        if (i < size && data[i] == '%') {
+            while (i < size && data[i] != '\n')
+                ++i;
+            continue;
+        }
+        if (i >= size || data[i] != '[')
+            break;
+        if (game.tags.empty())
+            game.offset = i;
+        size_t nameStart = ++i;
+        while (i < size && !isSpace(data[i]) && data[i] != '"' && data[i] != ']')
+            ++i;
+        string_view name(data + nameStart, i - nameStart);
+        while (i < size && data[i] != '"' && data[i] != ']' && data[i] != '\n')
+            ++i;
+        string_view value;
+        if (i < size && data[i] == '"') {
+            size_t valueStart = ++i;
+            while (i < size && data[i] != '"' && data[i] != '\n') {
+                if (data[i] == '\\' && i + 1 < size)
+                    ++i;
+                ++i;
+            }
+            value = string_view(data + valueStart, i - valueStart);
+        }
+        while (i < size && data[i] != '\n')
+            ++i;
+        game.tags.push_back({ name, value });
+    }
+    if (game.tags.empty())
+        game.offset = i;
+
+    // Movetext up to the result, or up to the next tag section if it is missing.
+    size_t start = i;
+    size_t end = i;
+    while (i < size) {
+        char c = data[i];
+        if (c == '{') {
+            while (i < size && data[i] != '}')
+                ++i;
+            ++i;
+        } else if (c == ';') {
+            while (i < size && data[i] != '\n')
+                ++i;
+        } else if (c == '[' && i > 0 && data[i - 1] == '\n') {
+            break;
+        } else if ((c == '1' || c == '0' || c == '*') && (i == start || isSpace(data[i - 1]))) {
+            size_t length = resultLength(string_view(data + i, size - i));
+            if (length) {
+                game.result = string_view(data + i, length);
+                i += length;
+                break;
+            }
+            ++i;
+        } else {
+            ++i;
+        }
+        end = i;
+    }
+    if (i > size)
+        i = size;
+    if (end > size)
+        end = size;
+    game.movetext = string_view(data + start, end - start);
+    cursor = i;
+    return !game.tags.empty() || !game.result.empty() || game.movetext.find_first_not_of(" \t\r\n") != string_view::npos;
+}
+
+PgnReplay replayGame(const PgnGame &game, vector<Move> *moves) {
+    PgnReplay replay;
+    string_view fen = game.tag("FEN");
+    if (fen.empty()) {
+        replay.position.setStartPosition();
+    } else if (!replay.position.setFromFen(fen)) {
+        replay.ok = false;
+        replay.error = "bad FEN";
+        replay.token = fen;
+        return replay;
+    }
+
+    SanTokenizer tokens(game.movetext);
+    string_view san;
+    while (tokens.next(san)) {
+        Move move = parseSan(replay.position, san);
+        if (move.isNone()) {
+            replay.ok = false;
+            replay.error = "illegal move";
+            replay.token = san;
+            break;
+        }
+        replay.position.makeMove(move);
+        ++replay.plies;
+        if (moves)
+            moves->push_back(move);
+    }
+    return replay;
+}
+
+string writePgn(const Game &game, const vector<PgnTag> &tags, string_view result) {
+    string text;
+    auto addTag = [&text](string_view name, string_view value) {
+        text += '[';
+        text += name;
+        text += " \"";
+        text += value;
+        text += "\"]\n";
+    };
+
+    auto find = [&tags](string_view name) {
+        for (const PgnTag &t : tags) {
+            if (t.name == name)
+                return t.value;
+        }
+        return string_view();
+    };
+    for (int i = 0; i < 6; ++i) {
+        string_view value = find(ROSTER[i]);
+        addTag(ROSTER[i], value.empty() ? ROSTER_DEFAULTS[i] : value);
+    }
+    addTag("Result", result);
+
+    Position start;
+    start.setStartPosition();
+    string startFen = game.getStartPosition().toFen();
+    if (startFen != start.toFen()) {
+        addTag("SetUp", "1");
+        addTag("FEN", startFen);
+    }
+    for (const PgnTag &t : tags) {
+        bool written = t.name == "Result" || t.name == "SetUp" || t.name == "FEN";
+        for (const char *name : ROSTER)
+            written |= t.name == name;
+        if (!written)
+            addTag(t.name, t.value);
+    }
+    text += '\n';
+
+    // Moves, wrapped before a token would pass column 80.
+    Position pos = game.getStartPosition();
+    size_t lineStart = text.size();
+    auto addToken = [&text, &lineStart](const string &token) {
+        if (text.size() > lineStart && text.size() - lineStart + 1 + token.size() > 80) {
+            text += '\n';
+            lineStart = text.size();
+        } else if (text.size() > lineStart) {
+            text += ' ';
+        }
+        text += token;
+    };
+    const vector<Move> &moves = game.getMoves();
+    for (size_t ply = 0; ply < moves.size(); ++ply) {
+        if (pos.sideToMove == WHITE)
+            addToken(to_string(pos.fullmoveNumber) + ".");
+        else if (ply == 0)
+            addToken(to_string(pos.fullmoveNumber) + "...");
+        addToken(toSan(pos, moves[ply]));
+        pos.makeMove(moves[ply]);
+    }
+    addToken(string(result));
+    text += "\n\n";
+    return text;
+}
@@ -0,0 +1,83 @@
+#ifndef PGN_HPP
+#define PGN_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Game.hpp"
+#include "MappedFile.hpp"
+
+// A tag pair such as [White "Carlsen"]. The value is the text between the
+// quotes with escapes left as written.
+struct PgnTag {
+    std::string_view name;
+    std::string_view value;
+};
+
+// One game of a PGN file. All views point into the reader's mapping and
+// stay valid until the reader is closed or opens another file.
+struct PgnGame {
+    std::vector<PgnTag> tags;
+    std::string_view movetext; // everything between the tags and the result
+    std::string_view result;   // "1-0", "0-1", "1/2-1/2", "*", or empty if missing
+    size_t offset = 0;         // byte offset of the game in the file
+
+    // Value of the named tag, or an empty view.
+    std::string_view tag(std::string_view name) const;
+};
+
+// Walks the SAN tokens of a movetext, skipping move numbers, comments,
+// variations, NAGs and the result.
+class SanTokenizer {
+public:
+    explicit SanTokenizer(std::string_view movetext) : rest(movetext) {}
+    // Next SAN token, or false at the end.
+    bool next(std::string_view &san);
+
+private:
+    std::string_view rest;
+};
+
+// Streams the games of a PGN file. The file is memory-mapped and split in
+// place, so reading allocates nothing per token, and pages already parsed
+// are handed back to the kernel: memory stays bounded however large the
+// file is.
+class PgnReader {
+public:
+    bool open(const std::string &path);
+    // Reads games from text owned by the caller instead, e.g. one shard of a
+    // file mapped elsewhere.
+    void setText(std::string_view text);
+    // Reads the next game into game, reusing its tag storage. False at the end of the file.
+    bool next(PgnGame &game);
+    // Bytes of the file consumed so far, for progress reports.
+    size_t position() const { return cursor; }
+    size_t size() const { return text.size(); }
+
+private:
+    MappedFile file;
+    std::string_view text;
+    size_t cursor = 0;
+    size_t released = 0; // pages before this offset were returned to the kernel
+};
+
+// Outcome of playing a game's movetext.
+struct PgnReplay {
+    bool ok = true;
+    size_t plies = 0;             // moves played
+    const char *error = nullptr;  // what went wrong when !ok
+    std::string_view token;       // offending SAN or FEN when !ok
+    Position position;            // position after the last move played
+};
+
+// Plays the moves of game from its FEN tag, or from the initial position,
+// until the end or the first move that is not legal. Moves are appended to
+// moves when it is not null.
+PgnReplay replayGame(const PgnGame &game, std::vector<Move> *moves = nullptr);
+
+// The game as PGN text: the seven-tag roster (filled with "?" where tags
+// lacks a value), SetUp/FEN for a non-standard start, and the moves in SAN
+// wrapped at 80 columns. result is one of the four PGN results.
+std::string writePgn(const Game &game, const std::vector<PgnTag> &tags, std::string_view result);
+
+#endif // PGN_HPP
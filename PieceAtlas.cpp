@@ -0,0 +1,61 @@
+#include "PieceAtlas.hpp"
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+// Gap between cells so filtering never samples a neighbouring piece.
+const unsigned PADDING = 2;
+
+}
+
+bool PieceAtlas::load(const string &directory) {
+    const char *colors = "wb";
+    const char *types = "PNBRQK";
+    sf::Image images[12];
+    bool loaded[12] = {};
+    bool complete = true;
+    unsigned cellWidth = 1, cellHeight = 1;
+    for (int p = W_PAWN; p <= B_KING; ++p) {
+        string file = string(1, colors[colorOf(PieceCode(p))]) + types[typeOf(PieceCode(p))] + ".png";
+        loaded[p] = images[p].loadFromFile(directory + file);
+        if (!loaded[p]) {
+            cerr << "Error loading " << file << "\n";
+            complete = false;
+            continue;
+        }
+        cellWidth = max(cellWidth, images[p].getSize().x);
+        cellHeight = max(cellHeight, images[p].getSize().y);
+    }
+
+    // One row per color, one column per piece type.
+    unsigned strideX = cellWidth + PADDING, strideY = cellHeight + PADDING;
+    sf::Image atlas;
+    atlas.create(6 * strideX, 2 * strideY, sf::Color(0, 0, 0, 0));
+    for (int p = W_PAWN; p <= B_KING; ++p) {
+        unsigned x = typeOf(PieceCode(p)) * strideX;
+        unsigned y = colorOf(PieceCode(p)) * strideY;
+        if (!loaded[p]) {
+            cells[p] = sf::IntRect(x, y, 0, 0);
+            continue;
+        }
+        atlas.copy(images[p], x, y);
+        cells[p] = sf::IntRect(x, y, images[p].getSize().x, images[p].getSize().y);
+    }
+    texture.loadFromImage(atlas);
+    return complete;
+}
+
+void PieceAtlas::appendQuad(sf::VertexArray &vertices, PieceCode piece, sf::Vector2f center) const {
+    const sf::IntRect &cell = cells[piece];
+    float left = center.x - cell.width / 2.f, top = center.y - cell.height / 2.f;
+    float right = left + cell.width, bottom = top + cell.height;
+    float u0 = float(cell.left), v0 = float(cell.top);
+    float u1 = u0 + cell.width, v1 = v0 + cell.height;
+    vertices.append(sf::Vertex(sf::Vector2f(left, top), sf::Vector2f(u0, v0)));
+    vertices.append(sf::Vertex(sf::Vector2f(right, top), sf::Vector2f(u1, v0)));
+    vertices.append(sf::Vertex(sf::Vector2f(right, bottom), sf::Vector2f(u1, v1)));
+    vertices.append(sf::Vertex(sf::Vector2f(left, bottom), sf::Vector2f(u0, v1)));
+}
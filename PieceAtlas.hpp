@@ -0,0 +1,27 @@
+#ifndef PIECE_ATLAS_HPP
+#define PIECE_ATLAS_HPP
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include "Bitboard.hpp"
+
+// All twelve piece images packed into one texture, so any number of pieces
+// can be drawn as a single vertex array with one texture bind.
+class PieceAtlas {
+public:
+    // Reads wP.png .. bK.png from directory (with trailing separator).
+    // Missing files leave their cell empty; returns false if any was missing.
+    bool load(const std::string &directory);
+
+    const sf::Texture &getTexture() const { return texture; }
+
+    // Appends one quad (four vertices, for sf::Quads) showing piece at its
+    // natural size, centred on center.
+    void appendQuad(sf::VertexArray &vertices, PieceCode piece, sf::Vector2f center) const;
+
+private:
+    sf::Texture texture;
+    sf::IntRect cells[12]; // area of each PieceCode inside the texture
+};
+
+#endif // PIECE_ATLAS_HPP
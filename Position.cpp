@@ -0,0 +1,371 @@
+#include "Position.hpp"
+#include "Attacks.hpp"
+#include "Evaluate.hpp"
+#include "MoveGen.hpp"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Castling rights that survive a move touching the given square.
+struct CastlingMask {
+    uint8_t mask[64];
+    CastlingMask() {
+        for (int sq = 0; sq < 64; ++sq)
+            mask[sq] = WHITE_OO | WHITE_OOO | BLACK_OO | BLACK_OOO;
+        mask[makeSquare(4, 0)] &= ~(WHITE_OO | WHITE_OOO);
+        mask[makeSquare(7, 0)] &= ~WHITE_OO;
+        mask[makeSquare(0, 0)] &= ~WHITE_OOO;
+        mask[makeSquare(4, 7)] &= ~(BLACK_OO | BLACK_OOO);
+        mask[makeSquare(7, 7)] &= ~BLACK_OO;
+        mask[makeSquare(0, 7)] &= ~BLACK_OOO;
+    }
+};
+
+const CastlingMask castlingMask;
+
+}
+
+void Position::clear() {
+    memset(this, 0, sizeof(Position));
+    sideToMove = WHITE;
+    epSquare = NO_SQUARE;
+    fullmoveNumber = 1;
+}
+
+void Position::setStartPosition() {
+    clear();
+    const PieceType backRank[8] = { ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK };
+    for (int file = 0; file < 8; ++file) {
+        putPiece(makePiece(WHITE, backRank[file]), makeSquare(file, 0));
+        putPiece(makePiece(WHITE, PAWN), makeSquare(file, 1));
+        putPiece(makePiece(BLACK, PAWN), makeSquare(file, 6));
+        putPiece(makePiece(BLACK, backRank[file]), makeSquare(file, 7));
+    }
+    castling = WHITE_OO | WHITE_OOO | BLACK_OO | BLACK_OOO;
+    key = computeKey();
+}
+
+namespace {
+
+const char PIECE_CHARS[] = "PNBRQKpnbrqk";
+
+bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Reads an unsigned decimal field that must end at whitespace or the end of
+// the text. Returns false if there is no digit or something else follows.
+bool parseCounter(std::string_view fen, size_t &i, unsigned &value) {
+    size_t start = i;
+    value = 0;
+    for (; i < fen.size() && fen[i] >= '0' && fen[i] <= '9'; ++i) {
+        if (value < 100000)
+            value = value * 10 + unsigned(fen[i] - '0');
+    }
+    return i > start && (i == fen.size() || isBlank(fen[i]));
+}
+
+}
+
+bool Position::setFromFen(std::string_view fen) {
+    clear();
+    // Lines from files, pipes and the clipboard often end in "\r\n".
+    while (!fen.empty() && isBlank(fen.back()))
+        fen.remove_suffix(1);
+    size_t i = 0;
+    while (i < fen.size() && fen[i] == ' ')
+        ++i;
+
+    int file = 0, rank = 7;
+    for (; i < fen.size() && fen[i] != ' '; ++i) {
+        char c = fen[i];
+        if (c == '/') {
+            if (file != 8 || rank == 0)
+                return false;
+            file = 0;
+            --rank;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else {
+            const char *found = c ? strchr(PIECE_CHARS, c) : nullptr;
+            if (!found || file > 7)
+                return false;
+            putPiece(PieceCode(found - PIECE_CHARS), makeSquare(file, rank));
+            ++file;
+        }
+        if (file > 8)
+            return false;
+    }
+    if (file != 8 || rank != 0 || i + 2 > fen.size())
+        return false;
+
+    ++i;
+    if (fen[i] == 'w')
+        sideToMove = WHITE;
+    else if (fen[i] == 'b')
+        sideToMove = BLACK;
+    else
+        return false;
+    ++i;
+
+    // Castling and en passant may be left out entirely, as some tools do.
+    if (i + 1 < fen.size()) {
+        for (++i; i < fen.size() && fen[i] != ' '; ++i) {
+            switch (fen[i]) {
+                case 'K': castling |= WHITE_OO; break;
+                case 'Q': castling |= WHITE_OOO; break;
+                case 'k': castling |= BLACK_OO; break;
+                case 'q': castling |= BLACK_OOO; break;
+                case '-': break;
+                default: return false;
+            }
+        }
+    }
+    // A right only survives if king and rook still stand on their home squares.
+    if (!(piecesOf(WHITE, KING) & squareBB(makeSquare(4, 0))))
+        castling &= ~(WHITE_OO | WHITE_OOO);
+    if (!(piecesOf(WHITE, ROOK) & squareBB(makeSquare(7, 0))))
+        castling &= ~WHITE_OO;
+    if (!(piecesOf(WHITE, ROOK) & squareBB(makeSquare(0, 0))))
+        castling &= ~WHITE_OOO;
+    if (!(piecesOf(BLACK, KING) & squareBB(makeSquare(4, 7))))
+        castling &= ~(BLACK_OO | BLACK_OOO);
+    if (!(piecesOf(BLACK, ROOK) & squareBB(makeSquare(7, 7))))
+        castling &= ~BLACK_OO;
+    if (!(piecesOf(BLACK, ROOK) & squareBB(makeSquare(0, 7))))
+        castling &= ~BLACK_OOO;
+
+    if (i + 1 < fen.size()) {
+        ++i;
+        if (fen[i] != '-') {
+            if (i + 1 >= fen.size() || fen[i] < 'a' || fen[i] > 'h' || fen[i + 1] < '1' || fen[i + 1] > '8')
+                return false;
+            int sq = makeSquare(fen[i] - 'a', fen[i + 1] - '1');
+            int up = sideToMove == WHITE ? 8 : -8;
+            // Only a pawn that just advanced two squares past sq can leave it,
+            // and as in makeMove it is only kept when a pawn can capture.
+            if (rankOf(sq) == (sideToMove == WHITE ? 5 : 2) && pieceOn(sq) == NO_PIECE
+                && pieceOn(sq + up) == NO_PIECE && (piecesOf(~sideToMove, PAWN) & squareBB(sq - up))
+                && (pawnAttacks(~sideToMove, sq) & piecesOf(sideToMove, PAWN)))
+                epSquare = uint8_t(sq);
+            ++i;
+        }
+        ++i;
+    }
+
+    // The move counters are optional.
+    unsigned value;
+    if (i + 1 < fen.size()) {
+        ++i;
+        if (!parseCounter(fen, i, value))
+            return false;
+        halfmoveClock = uint8_t(value < 255 ? value : 255);
+        if (i + 1 < fen.size()) {
+            ++i;
+            if (!parseCounter(fen, i, value))
+                return false;
+            fullmoveNumber = uint16_t(value < 65535 ? value : 65535);
+        }
+    }
+    if (fullmoveNumber == 0)
+        fullmoveNumber = 1;
+    key = computeKey();
+    if (popCount(piecesOf(WHITE, KING)) != 1 || popCount(piecesOf(BLACK, KING)) != 1)
+        return false;
+    // Move generation relies on pawns never standing on the back ranks, and
+    // the side that just moved cannot have left its king in check.
+    if ((pieces[W_PAWN] | pieces[B_PAWN]) & (RANK_1 | RANK_8))
+        return false;
+    return !isInCheck(*this, ~sideToMove);
+}
+
+size_t Position::writeFen(char *out) const {
+    char *p = out;
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < 8; ++file) {
+            PieceCode piece = pieceOn(makeSquare(file, rank));
+            if (piece == NO_PIECE) {
+                ++empty;
+                continue;
+            }
+            if (empty)
+                *p++ = char('0' + empty);
+            empty = 0;
+            *p++ = PIECE_CHARS[piece];
+        }
+        if (empty)
+            *p++ = char('0' + empty);
+        if (rank)
+            *p++ = '/';
+    }
+    *p++ = ' ';
+    *p++ = sideToMove == WHITE ? 'w' : 'b';
+    *p++ = ' ';
+    if (!castling)
+        *p++ = '-';
+    if (castling & WHITE_OO) *p++ = 'K';
+    if (castling & WHITE_OOO) *p++ = 'Q';
+    if (castling & BLACK_OO) *p++ = 'k';
+    if (castling & BLACK_OOO) *p++ = 'q';
+    *p++ = ' ';
+    if (epSquare == NO_SQUARE) {
+        *p++ = '-';
+    } else {
+        *p++ = char('a' + fileOf(epSquare));
+        *p++ = char('1' + rankOf(epSquare));
+    }
+    p += snprintf(p, 14, " %u %u", unsigned(halfmoveClock), unsigned(fullmoveNumber));
+    return size_t(p - out);
+}
+
+std::string Position::toFen() const {
+    char buffer[MAX_FEN_LENGTH];
+    return std::string(buffer, writeFen(buffer));
+}
+
+uint64_t Position::computeKey() const {
+    uint64_t k = ZOBRIST.castling[castling];
+    for (int p = W_PAWN; p <= B_KING; ++p) {
+        for (Bitboard b = pieces[p]; b; )
+            k ^= ZOBRIST.piece[p][popLsb(b)];
+    }
+    if (epSquare != NO_SQUARE)
+        k ^= ZOBRIST.epFile[fileOf(epSquare)];
+    if (sideToMove == BLACK)
+        k ^= ZOBRIST.side;
+    return k;
+}
+
+PieceCode Position::pieceOn(int sq) const {
+    Bitboard bb = squareBB(sq);
+    if (!(occupied[2] & bb))
+        return NO_PIECE;
+    int first = (occupied[WHITE] & bb) ? W_PAWN : B_PAWN;
+    for (int p = first; p < first + 6; ++p) {
+        if (pieces[p] & bb)
+            return PieceCode(p);
+    }
+    return NO_PIECE;
+}
+
+void Position::putPiece(PieceCode p, int sq) {
+    Bitboard bb = squareBB(sq);
+    pieces[p] |= bb;
+    occupied[colorOf(p)] |= bb;
+    occupied[2] |= bb;
+    key ^= ZOBRIST.piece[p][sq];
+    psq[MIDGAME] += PSQ.score[p][sq][MIDGAME];
+    psq[ENDGAME] += PSQ.score[p][sq][ENDGAME];
+    phase += PHASE_WEIGHTS[typeOf(p)];
+    if (typeOf(p) == KING)
+        kingSquare[colorOf(p)] = uint8_t(sq);
+}
+
+void Position::removePiece(PieceCode p, int sq) {
+    Bitboard bb = ~squareBB(sq);
+    pieces[p] &= bb;
+    occupied[colorOf(p)] &= bb;
+    occupied[2] &= bb;
+    key ^= ZOBRIST.piece[p][sq];
+    psq[MIDGAME] -= PSQ.score[p][sq][MIDGAME];
+    psq[ENDGAME] -= PSQ.score[p][sq][ENDGAME];
+    phase -= PHASE_WEIGHTS[typeOf(p)];
+}
+
+void Position::makeMove(const Move &move) {
+    Color us = sideToMove;
+    int from = move.from(), to = move.to();
+    PieceCode moving = pieceOn(from);
+
+    if (halfmoveClock < 255)
+        ++halfmoveClock;
+    if (typeOf(moving) == PAWN)
+        halfmoveClock = 0;
+
+    if (move.type() == EN_PASSANT) {
+        removePiece(makePiece(~us, PAWN), us == WHITE ? to - 8 : to + 8);
+    } else if (occupied[~us] & squareBB(to)) {
+        removePiece(pieceOn(to), to);
+        halfmoveClock = 0;
+    }
+
+    removePiece(moving, from);
+    putPiece(move.type() == PROMOTION ? makePiece(us, move.promotion()) : moving, to);
+
+    if (move.type() == CASTLING) {
+        // The rook jumps to the square the king passed over.
+        bool kingside = to > from;
+        int rookFrom = kingside ? from + 3 : from - 4;
+        int rookTo = kingside ? from + 1 : from - 1;
+        removePiece(makePiece(us, ROOK), rookFrom);
+        putPiece(makePiece(us, ROOK), rookTo);
+    }
+
+    key ^= ZOBRIST.castling[castling];
+    castling &= castlingMask.mask[from] & castlingMask.mask[to];
+    key ^= ZOBRIST.castling[castling];
+
+    if (epSquare != NO_SQUARE)
+        key ^= ZOBRIST.epFile[fileOf(epSquare)];
+    epSquare = NO_SQUARE;
+    if (typeOf(moving) == PAWN && (to ^ from) == 16
+        && (pawnAttacks(us, (from + to) / 2) & piecesOf(~us, PAWN))) {
+        epSquare = uint8_t((from + to) / 2);
+        key ^= ZOBRIST.epFile[fileOf(epSquare)];
+    }
+
+    if (us == BLACK)
+        ++fullmoveNumber;
+    sideToMove = ~us;
+    key ^= ZOBRIST.side;
+}
+
+void Position::makeMove(const Move &move, UndoInfo &undo) {
+    undo.captured = move.type() == EN_PASSANT ? makePiece(~sideToMove, PAWN) : pieceOn(move.to());
+    undo.castling = castling;
+    undo.epSquare = epSquare;
+    undo.halfmoveClock = halfmoveClock;
+    makeMove(move);
+}
+
+void Position::unmakeMove(const Move &move, const UndoInfo &undo) {
+    sideToMove = ~sideToMove;
+    key ^= ZOBRIST.side;
+    Color us = sideToMove;
+    if (us == BLACK)
+        --fullmoveNumber;
+    int from = move.from(), to = move.to();
+
+    key ^= ZOBRIST.castling[castling] ^ ZOBRIST.castling[undo.castling];
+    castling = undo.castling;
+    if (epSquare != NO_SQUARE)
+        key ^= ZOBRIST.epFile[fileOf(epSquare)];
+    epSquare = undo.epSquare;
+    if (epSquare != NO_SQUARE)
+        key ^= ZOBRIST.epFile[fileOf(epSquare)];
+    halfmoveClock = undo.halfmoveClock;
+
+    if (move.type() == CASTLING) {
+        bool kingside = to > from;
+        removePiece(makePiece(us, ROOK), kingside ? from + 1 : from - 1);
+        putPiece(makePiece(us, ROOK), kingside ? from + 3 : from - 4);
+    }
+    PieceCode placed = pieceOn(to);
+    removePiece(placed, to);
+    putPiece(move.type() == PROMOTION ? makePiece(us, PAWN) : placed, from);
+    if (undo.captured != NO_PIECE)
+        putPiece(undo.captured, move.type() == EN_PASSANT ? (us == WHITE ? to - 8 : to + 8) : to);
+}
+
+void Position::makeNullMove() {
+    if (epSquare != NO_SQUARE) {
+        key ^= ZOBRIST.epFile[fileOf(epSquare)];
+        epSquare = NO_SQUARE;
+    }
+    // Repetition checks must not look back across a pass.
+    halfmoveClock = 0;
+    sideToMove = ~sideToMove;
+    key ^= ZOBRIST.side;
+}
@@ -0,0 +1,75 @@
+#ifndef POSITION_HPP
+#define POSITION_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "Bitboard.hpp"
+#include "Move.hpp"
+#include "Zobrist.hpp"
+
+enum CastlingRight : uint8_t {
+    WHITE_OO  = 1,
+    WHITE_OOO = 2,
+    BLACK_OO  = 4,
+    BLACK_OOO = 8
+};
+
+// Longest FEN writeFen can produce: 64 squares and 7 separators, the four
+// short fields and two counters.
+const size_t MAX_FEN_LENGTH = 96;
+
+// What a move destroys and unmakeMove needs back. Four bytes.
+struct UndoInfo {
+    PieceCode captured;    // NO_PIECE if the move captured nothing
+    uint8_t castling;
+    uint8_t epSquare;
+    uint8_t halfmoveClock;
+};
+
+// Complete game state in bitboard form. Trivially copyable, so legality
+// probes and searches work on copies instead of mutating a shared board.
+struct Position {
+    Bitboard pieces[12];   // indexed by PieceCode
+    Bitboard occupied[3];  // [WHITE], [BLACK] and [2] for both colors
+    Color sideToMove;
+    uint8_t castling;      // CastlingRight bits
+    uint8_t epSquare;      // square behind a pawn that just double-pushed and can be taken, or NO_SQUARE
+    uint8_t halfmoveClock;
+    uint16_t fullmoveNumber;
+    uint8_t kingSquare[2]; // kept up to date by putPiece
+    uint64_t key;          // Zobrist hash, updated incrementally by every change
+    int16_t psq[2];        // PSQ sums of all pieces, white minus black, [MIDGAME] and [ENDGAME]; kept by putPiece
+    uint8_t phase;         // sum of PHASE_WEIGHTS over the pieces; kept by putPiece
+
+    void clear();
+    void setStartPosition();
+    // Loads a position in Forsyth-Edwards Notation. Returns false on malformed
+    // input. Works on the text in place and never allocates; the move counters
+    // may be omitted, and castling rights without king and rook at home are dropped.
+    bool setFromFen(std::string_view fen);
+    // Writes the FEN without a terminating zero into out, which must hold
+    // MAX_FEN_LENGTH chars. Returns the length.
+    size_t writeFen(char *out) const;
+    std::string toFen() const;
+
+    PieceCode pieceOn(int sq) const;
+    Bitboard piecesOf(Color c, PieceType t) const { return pieces[makePiece(c, t)]; }
+    Bitboard all() const { return occupied[2]; }
+    // Hash computed from scratch; equals key in every consistent position.
+    uint64_t computeKey() const;
+
+    void putPiece(PieceCode p, int sq);
+    void removePiece(PieceCode p, int sq);
+
+    // Plays a move produced by the move generator. No legality checks.
+    void makeMove(const Move &move);
+    // Same, recording what is needed to take the move back.
+    void makeMove(const Move &move, UndoInfo &undo);
+    // Takes back the last move made with the given undo record.
+    void unmakeMove(const Move &move, const UndoInfo &undo);
+    // Passes the turn without moving. Only valid when not in check.
+    void makeNullMove();
+};
+
+#endif // POSITION_HPP
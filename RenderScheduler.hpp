@@ -0,0 +1,73 @@
+#ifndef RENDER_SCHEDULER_HPP
+#define RENDER_SCHEDULER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+// Decides when the window is redrawn. Frames are drawn only after something
+// changed, and never faster than the frame cap. When nothing can change on
+// its own the main loop blocks on the next event; otherwise it sleeps in
+// slices that grow while no input arrives, and only polls for events.
+class RenderScheduler {
+public:
+    // maxFps 0 means no cap.
+    explicit RenderScheduler(int maxFps = 60) {
+        setFrameCap(maxFps);
+    }
+
+    void setFrameCap(int maxFps) {
+        minFrameTime = maxFps > 0 ? std::chrono::microseconds(1000000 / maxFps) : std::chrono::microseconds(0);
+    }
+
+    // Something on screen changed.
+    void invalidate() {
+        dirty = true;
+    }
+
+    // An event arrived: the user is active, so poll at the shortest slice.
+    void inputReceived() {
+        dirty = true;
+        idleSlice = MIN_IDLE_SLICE;
+    }
+
+    // A frame is waiting to be drawn.
+    bool isDirty() const {
+        return dirty;
+    }
+
+    // A frame should be drawn now.
+    bool shouldDraw() const {
+        return dirty && std::chrono::steady_clock::now() - lastFrame >= minFrameTime;
+    }
+
+    void frameDrawn() {
+        dirty = false;
+        lastFrame = std::chrono::steady_clock::now();
+    }
+
+    // Sleeps until the capped frame is due, or one idle slice if nothing changed.
+    void wait() {
+        auto next = std::chrono::steady_clock::now() + idleSlice;
+        if (dirty && lastFrame + minFrameTime < next)
+            next = lastFrame + minFrameTime;
+        else
+            idleSlice = std::min(idleSlice * 2, MAX_IDLE_SLICE);
+        std::this_thread::sleep_until(next);
+    }
+
+private:
+    // Events are only noticed between sleeps, so the slice bounds input
+    // latency. SFML 2.6 cannot wait for an event with a timeout, so while a
+    // clock runs or the engine thinks the loop has to poll; a mouse move
+    // brings the slice back down before the click that follows it.
+    static constexpr std::chrono::milliseconds MIN_IDLE_SLICE{10};
+    static constexpr std::chrono::milliseconds MAX_IDLE_SLICE{80};
+
+    std::chrono::milliseconds idleSlice = MIN_IDLE_SLICE;
+    std::chrono::steady_clock::duration minFrameTime{};
+    std::chrono::steady_clock::time_point lastFrame{};
+    bool dirty = true;
+};
+
+#endif // RENDER_SCHEDULER_HPP
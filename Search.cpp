@@ -0,0 +1,599 @@
+#include "Search.hpp"
+#include "Evaluate.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// Victim values for capture ordering.
+const int PIECE_VALUES[6] = { 100, 320, 330, 500, 900, 0 };
+
+struct Reductions {
+    int table[64][64];
+    Reductions() {
+        for (int depth = 0; depth < 64; ++depth) {
+            for (int count = 0; count < 64; ++count)
+                table[depth][count] = (depth && count) ? int(0.75 + log(depth) * log(count) / 2.25) : 0;
+        }
+    }
+};
+
+const Reductions reductions;
+
+bool isCapture(const Position &pos, Move move) {
+    return move.type() == EN_PASSANT || (pos.occupied[~pos.sideToMove] & squareBB(move.to()));
+}
+
+bool hasNonPawnMaterial(const Position &pos, Color c) {
+    return (pos.occupied[c] & ~pos.piecesOf(c, PAWN) & ~pos.piecesOf(c, KING)) != 0;
+}
+
+// Mate scores are stored relative to the node, not the root.
+int scoreToTT(int score, int ply) {
+    return score >= MATE_IN_MAX_PLY ? score + ply : score <= -MATE_IN_MAX_PLY ? score - ply : score;
+}
+
+int scoreFromTT(int score, int ply) {
+    return score >= MATE_IN_MAX_PLY ? score - ply : score <= -MATE_IN_MAX_PLY ? score + ply : score;
+}
+
+// Helper threads skip some iterations so that, at any moment, they are
+// spread over more than one depth. Indexed by (thread - 1) % 20.
+const int SKIP_SIZE[20] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+const int SKIP_PHASE[20] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+// A position since the last capture or pawn move occurred twice, counting
+// the root. Such a game cannot afford to repeat again to convert a win.
+bool hasRepeated(const vector<uint64_t> &history, const Position &root) {
+    vector<uint64_t> keys(history.end() - min<size_t>(root.halfmoveClock, history.size()), history.end());
+    keys.push_back(root.key);
+    for (size_t i = keys.size(); i-- > 0;) {
+        for (size_t j = i % 2; j < i; j += 2) {
+            if (keys[j] == keys[i])
+                return true;
+        }
+    }
+    return false;
+}
+
+// Root moves after which the game is drawn at once: the position reached
+// occurs for the third time since the last capture or pawn move, or the
+// fifty-move rule ends the game without a mate.
+void markDrawingMoves(const vector<uint64_t> &history, const Position &root, const MoveList &moves, bool drawn[]) {
+    vector<uint64_t> keys(history.end() - min<size_t>(root.halfmoveClock, history.size()), history.end());
+    keys.push_back(root.key);
+    for (int i = 0; i < moves.size(); ++i) {
+        Position next = root;
+        next.makeMove(moves[i]);
+        drawn[i] = next.halfmoveClock && ((next.halfmoveClock >= 100 && !isCheckmate(next))
+                                          || count(keys.begin(), keys.end(), next.key) >= 2);
+    }
+}
+
+// Selection sort step: moves the best-scored remaining move to index i.
+void pickMove(MoveList &moves, int scores[], int i) {
+    int best = i;
+    for (int j = i + 1; j < moves.size(); ++j) {
+        if (scores[j] > scores[best])
+            best = j;
+    }
+    swap(moves[i], moves[best]);
+    swap(scores[i], scores[best]);
+}
+
+}
+
+class Search::Worker {
+public:
+    Worker(Search &owner, int id) : owner(owner), id(id) {}
+
+    void start(const Position &root, const vector<uint64_t> &gameHistory);
+    void iterate(const Position &root);
+    uint64_t nodeCount() const { return nodes.load(memory_order_relaxed); }
+    uint64_t tbHitCount() const { return tbHits.load(memory_order_relaxed); }
+
+    Search &owner;
+    const int id;
+    TTStats ttStats;
+
+    // Result of the last completed iteration.
+    Move bestMove = Move();
+    Move ponderMove = Move();
+    int bestScore = 0;
+    int completedDepth = 0;
+
+private:
+    int search(const Position &pos, int alpha, int beta, int depth, int ply, bool allowNull);
+    int quiescence(const Position &pos, int alpha, int beta, int ply);
+    void orderMoves(const Position &pos, MoveList &moves, int scores[], Move ttMove, int ply) const;
+    bool isDraw(const Position &pos, int ply) const;
+    bool countNode();
+
+    // Written only by the owning thread; read by the main thread for reporting.
+    atomic<uint64_t> nodes{0};
+    atomic<uint64_t> tbHits{0};
+    int selDepth = 0;
+    vector<uint64_t> keys; // game history followed by one key per search ply
+    size_t rootKeyIndex = 0;
+
+    Move pv[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+    Move killers[MAX_PLY][2];
+    int history[2][64][64];
+};
+
+Search::Search(TranspositionTable &table) : table(table) {
+    setThreads(1);
+}
+
+Search::~Search() = default;
+
+void Search::setThreads(int count) {
+    workers.clear();
+    for (int i = 0; i < max(count, 1); ++i)
+        workers.emplace_back(new Worker(*this, i));
+}
+
+int64_t Search::elapsedMs() const {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+}
+
+bool Search::timeUp(int64_t limitMs) const {
+    return limitMs && !pondering && elapsedMs() - ponderhitMs >= limitMs;
+}
+
+vector<uint64_t> Search::threadNodes() const {
+    vector<uint64_t> counts;
+    for (const auto &worker : workers)
+        counts.push_back(worker->nodeCount());
+    return counts;
+}
+
+uint64_t Search::tbHits() const {
+    uint64_t total = 0;
+    for (const auto &worker : workers)
+        total += worker->tbHitCount();
+    return total;
+}
+
+// Called by the main thread only.
+void Search::checkLimits() {
+    bool outOfNodes = false;
+    if (limits.nodes) {
+        uint64_t total = 0;
+        for (const auto &worker : workers)
+            total += worker->nodeCount();
+        outOfNodes = total >= limits.nodes;
+    }
+    if (stopRequested || outOfNodes || timeUp(hardLimitMs))
+        stopped = true;
+}
+
+SearchResult Search::run(const Position &root, const vector<uint64_t> &gameHistory, const SearchLimits &searchLimits) {
+    startTime = chrono::steady_clock::now();
+    limits = searchLimits;
+    stopped = bool(stopRequested);
+    ponderhitMs = 0;
+    pondering = limits.ponder;
+    if (ponderhitRequested)
+        pondering = false;
+    table.newSearch();
+
+    // Spend a slice of the remaining clock, and never more than a fraction of it.
+    softLimitMs = hardLimitMs = 0;
+    if (limits.moveTimeMs) {
+        softLimitMs = hardLimitMs = limits.moveTimeMs;
+    } else if (!limits.infinite && limits.timeLeftMs[root.sideToMove]) {
+        int64_t left = limits.timeLeftMs[root.sideToMove];
+        int64_t increment = limits.incrementMs[root.sideToMove];
+        int movesToGo = limits.movesToGo ? limits.movesToGo : 30;
+        softLimitMs = left / movesToGo + increment * 3 / 4;
+        hardLimitMs = min(softLimitMs * 4, left / 3);
+        softLimitMs = min(softLimitMs, hardLimitMs);
+        softLimitMs = max<int64_t>(softLimitMs, 1);
+        hardLimitMs = max<int64_t>(hardLimitMs, 1);
+    }
+
+    SearchResult result;
+    rootMoves.clear();
+    generateLegalMoves(root, rootMoves);
+    if (rootMoves.empty()) {
+        stopRequested = false;
+        ponderhitRequested = false;
+        return result;
+    }
+
+    // A root in the tablebases searches only the moves that keep its result.
+    // Once DTZ has ranked them, probes below the root would only make every
+    // win look alike; without DTZ they help find how to convert one.
+    tbRoot = false;
+    tbPieces = tablebases ? min(tbProbeLimit, tablebases->maxPieces()) : 0;
+    WdlScore rootWdl;
+    bool byDtz;
+    if (tbPieces && popCount(root.all()) <= tbPieces) {
+        bool drawn[MoveList::CAPACITY];
+        markDrawingMoves(gameHistory, root, rootMoves, drawn);
+        if (tablebases->filterRootMoves(root, hasRepeated(gameHistory, root), drawn, rootMoves, rootWdl, byDtz)) {
+            tbRoot = true;
+            tbScore = rootWdl == WDL_WIN ? MATE_IN_MAX_PLY - 1 : rootWdl == WDL_LOSS ? -MATE_IN_MAX_PLY + 1 : 0;
+            if (byDtz || rootWdl <= WDL_DRAW)
+                tbPieces = 0;
+        }
+    }
+
+    for (auto &worker : workers)
+        worker->start(root, gameHistory);
+    vector<thread> helpers;
+    for (size_t i = 1; i < workers.size(); ++i)
+        helpers.emplace_back([this, i, &root]() { workers[i]->iterate(root); });
+    workers[0]->iterate(root);
+
+    // In infinite mode, and while pondering, the caller decides when the
+    // search is over.
+    while ((limits.infinite || pondering) && !stopRequested)
+        this_thread::sleep_for(chrono::microseconds(100));
+    stopped = true;
+    for (thread &helper : helpers)
+        helper.join();
+
+    // Trust a helper that finished a deeper iteration without a worse score.
+    const Worker *best = workers[0].get();
+    for (const auto &worker : workers) {
+        if (worker->completedDepth > best->completedDepth && worker->bestScore >= best->bestScore)
+            best = worker.get();
+    }
+    result.bestMove = best->completedDepth ? best->bestMove : rootMoves[0];
+    result.ponderMove = best->ponderMove;
+    result.score = best->bestScore;
+    if (tbRoot && abs(result.score) < MATE_IN_MAX_PLY)
+        result.score = tbScore;
+    result.depth = best->completedDepth;
+    result.threadNodes = threadNodes();
+    for (uint64_t count : result.threadNodes)
+        result.nodes += count;
+    for (const auto &worker : workers)
+        table.addStats(worker->ttStats);
+    stopRequested = false;
+    ponderhitRequested = false;
+    return result;
+}
+
+void Search::Worker::start(const Position &root, const vector<uint64_t> &gameHistory) {
+    nodes = 0;
+    tbHits = 0;
+    ttStats = TTStats();
+    bestMove = ponderMove = Move();
+    bestScore = 0;
+    completedDepth = 0;
+    memset(killers, 0, sizeof(killers));
+    memset(history, 0, sizeof(history));
+
+    keys = gameHistory;
+    rootKeyIndex = keys.size();
+    keys.resize(rootKeyIndex + MAX_PLY + 1);
+    keys[rootKeyIndex] = root.key;
+}
+
+void Search::Worker::iterate(const Position &root) {
+    const SearchLimits &limits = owner.limits;
+    bool mainThread = id == 0;
+    int maxDepth = limits.depth ? min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        if (!mainThread) {
+            int i = (id - 1) % 20;
+            if (((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2)
+                continue;
+        }
+        selDepth = 0;
+        int delta = 25;
+        int alpha = -INFINITE_SCORE, beta = INFINITE_SCORE;
+        if (depth >= 5) {
+            alpha = max(bestScore - delta, -INFINITE_SCORE);
+            beta = min(bestScore + delta, INFINITE_SCORE);
+        }
+        int score;
+        // Re-search with a wider window until the score falls inside it.
+        while (true) {
+            score = search(root, alpha, beta, depth, 0, false);
+            if (owner.stopped)
+                break;
+            if (score <= alpha) {
+                beta = (alpha + beta) / 2;
+                alpha = max(score - delta, -INFINITE_SCORE);
+            } else if (score >= beta) {
+                beta = min(score + delta, INFINITE_SCORE);
+            } else {
+                break;
+            }
+            delta += delta / 2;
+        }
+        // Keep a partial first iteration only if it completed a move.
+        if (owner.stopped && (completedDepth || pvLength[0] == 0))
+            break;
+
+        bestMove = pv[0][0];
+        ponderMove = pvLength[0] > 1 ? pv[0][1] : Move();
+        bestScore = score;
+        completedDepth = depth;
+        if (!mainThread)
+            continue;
+
+        if (owner.infoCallback) {
+            SearchInfo info;
+            info.depth = depth;
+            info.selDepth = selDepth;
+            info.score = owner.tbRoot && abs(score) < MATE_IN_MAX_PLY ? owner.tbScore : score;
+            info.threadNodes = owner.threadNodes();
+            for (uint64_t count : info.threadNodes)
+                info.nodes += count;
+            info.timeMs = owner.elapsedMs();
+            info.nps = info.nodes * 1000 / uint64_t(max<int64_t>(info.timeMs, 1));
+            info.tbHits = owner.tbHits();
+            info.pv.assign(pv[0], pv[0] + pvLength[0]);
+            owner.infoCallback(info);
+        }
+        if (owner.stopped)
+            break;
+        if (!limits.infinite && owner.timeUp(owner.softLimitMs))
+            break;
+        // A forced mate will not get shorter by searching deeper.
+        if (!limits.infinite && abs(score) >= MATE_IN_MAX_PLY && depth > MATE_SCORE - abs(score))
+            break;
+    }
+    // Whatever ended the main thread's search ends the helpers' too.
+    if (mainThread && !limits.infinite)
+        owner.stopped = true;
+}
+
+// Counts a node and reports whether the search must unwind.
+bool Search::Worker::countNode() {
+    uint64_t count = nodes.load(memory_order_relaxed) + 1;
+    nodes.store(count, memory_order_relaxed);
+    if (id == 0 && (count & 1023) == 0)
+        owner.checkLimits();
+    return owner.stopped.load(memory_order_relaxed);
+}
+
+bool Search::Worker::isDraw(const Position &pos, int ply) const {
+    if (pos.halfmoveClock >= 100)
+        return true;
+    // Only positions since the last capture or pawn move can repeat; one
+    // earlier occurrence is enough inside the search.
+    size_t index = rootKeyIndex + ply;
+    for (int back = 4; back <= pos.halfmoveClock && size_t(back) <= index; back += 2) {
+        if (keys[index - back] == pos.key)
+            return true;
+    }
+    return false;
+}
+
+void Search::Worker::orderMoves(const Position &pos, MoveList &moves, int scores[], Move ttMove, int ply) const {
+    Color us = pos.sideToMove;
+    for (int i = 0; i < moves.size(); ++i) {
+        Move move = moves[i];
+        if (move == ttMove) {
+            scores[i] = 1 << 30;
+        } else if (isCapture(pos, move)) {
+            // Most valuable victim, least valuable attacker.
+            PieceType victim = move.type() == EN_PASSANT ? PAWN : typeOf(pos.pieceOn(move.to()));
+            PieceType attacker = typeOf(pos.pieceOn(move.from()));
+            scores[i] = (1 << 24) + PIECE_VALUES[victim] * 8 - attacker;
+        } else if (move.promotion() == QUEEN) {
+            scores[i] = (1 << 24) - 1;
+        } else if (move == killers[ply][0]) {
+            scores[i] = (1 << 23) + 1;
+        } else if (move == killers[ply][1]) {
+            scores[i] = 1 << 23;
+        } else {
+            scores[i] = history[us][move.from()][move.to()];
+            // Helpers break history ties differently from each other.
+            if (id)
+                scores[i] += int((move.raw() * 2654435761u) >> (27 - id % 8)) & 63;
+        }
+    }
+}
+
+int Search::Worker::search(const Position &pos, int alpha, int beta, int depth, int ply, bool allowNull) {
+    bool pvNode = beta - alpha > 1;
+    bool rootNode = ply == 0;
+    pvLength[ply] = ply;
+
+    if (depth <= 0)
+        return quiescence(pos, alpha, beta, ply);
+
+    if (countNode())
+        return 0;
+    selDepth = max(selDepth, ply);
+
+    if (!rootNode) {
+        if (isDraw(pos, ply))
+            return 0;
+        if (ply >= MAX_PLY - 1)
+            return evaluate(pos);
+        // Mate distance pruning: a shorter mate was already found elsewhere.
+        alpha = max(alpha, -MATE_SCORE + ply);
+        beta = min(beta, MATE_SCORE - ply - 1);
+        if (alpha >= beta)
+            return alpha;
+    }
+
+    Color us = pos.sideToMove;
+    bool inCheck = isInCheck(pos, us);
+    if (inCheck && ply < MAX_PLY / 2)
+        ++depth;
+
+    TTData entry;
+    Move ttMove = Move();
+    if (owner.table.probe(pos.key, entry, &ttStats)) {
+        ttMove = entry.move;
+        int ttScore = scoreFromTT(entry.score, ply);
+        if (!pvNode && entry.depth >= depth
+            && (entry.bound == BOUND_EXACT
+                || (entry.bound == BOUND_LOWER && ttScore >= beta)
+                || (entry.bound == BOUND_UPPER && ttScore <= alpha)))
+            return ttScore;
+    }
+
+    // Right after a capture or pawn move a small enough position is solved.
+    // Wins and losses count as just short of any real mate.
+    if (!rootNode && owner.tbPieces && pos.halfmoveClock == 0 && !pos.castling
+        && popCount(pos.all()) <= owner.tbPieces) {
+        WdlScore wdl;
+        if (owner.tablebases->probeWdl(pos, wdl)) {
+            tbHits.store(tbHits.load(memory_order_relaxed) + 1, memory_order_relaxed);
+            int score = wdl == WDL_LOSS ? -MATE_IN_MAX_PLY + ply + 1
+                      : wdl == WDL_WIN ? MATE_IN_MAX_PLY - ply - 1
+                      : 2 * wdl; // the fifty-move rule draws cursed wins and blessed losses
+            Bound bound = wdl == WDL_LOSS ? BOUND_UPPER : wdl == WDL_WIN ? BOUND_LOWER : BOUND_EXACT;
+            if (bound == BOUND_EXACT || (bound == BOUND_LOWER ? score >= beta : score <= alpha)) {
+                owner.table.store(pos.key, min(depth + 6, MAX_PLY - 1), bound, scoreToTT(score, ply), Move(), 0, &ttStats);
+                return score;
+            }
+        }
+    }
+
+    int staticEval = inCheck ? -INFINITE_SCORE : evaluate(pos);
+
+    // Null move: if passing still fails high, a real move will too.
+    if (!pvNode && !inCheck && allowNull && depth >= 3 && staticEval >= beta && hasNonPawnMaterial(pos, us)) {
+        Position next = pos;
+        next.makeNullMove();
+        keys[rootKeyIndex + ply + 1] = next.key;
+        int reduction = 3 + depth / 6;
+        int score = -search(next, -beta, -beta + 1, depth - 1 - reduction, ply + 1, false);
+        if (owner.stopped)
+            return 0;
+        if (score >= beta)
+            return score >= MATE_IN_MAX_PLY ? beta : score;
+    }
+
+    MoveList moves;
+    if (rootNode)
+        moves = owner.rootMoves;
+    else
+        generateLegalMoves(pos, moves);
+    if (moves.empty())
+        return inCheck ? -MATE_SCORE + ply : 0;
+
+    int scores[MoveList::CAPACITY];
+    orderMoves(pos, moves, scores, ttMove, ply);
+
+    int best = -INFINITE_SCORE;
+    Move bestMove = Move();
+    Bound bound = BOUND_UPPER;
+    for (int i = 0; i < moves.size(); ++i) {
+        pickMove(moves, scores, i);
+        Move move = moves[i];
+        bool quiet = !isCapture(pos, move) && move.type() != PROMOTION;
+
+        Position next = pos;
+        next.makeMove(move);
+        keys[rootKeyIndex + ply + 1] = next.key;
+        int newDepth = depth - 1;
+        int score;
+        if (i == 0) {
+            score = -search(next, -beta, -alpha, newDepth, ply + 1, true);
+        } else {
+            // Late quiet moves are searched shallower first and only re-searched
+            // at full depth if they unexpectedly beat alpha.
+            int reduction = 0;
+            if (depth >= 3 && quiet && i >= (pvNode ? 3 : 2) && !inCheck && !isInCheck(next, next.sideToMove)) {
+                reduction = reductions.table[min(depth, 63)][min(i, 63)];
+                if (pvNode)
+                    --reduction;
+                reduction = max(0, min(reduction, newDepth - 1));
+            }
+            score = -search(next, -alpha - 1, -alpha, newDepth - reduction, ply + 1, true);
+            if (score > alpha && reduction)
+                score = -search(next, -alpha - 1, -alpha, newDepth, ply + 1, true);
+            if (score > alpha && score < beta)
+                score = -search(next, -beta, -alpha, newDepth, ply + 1, true);
+        }
+        if (owner.stopped)
+            return 0;
+
+        if (score > best) {
+            best = score;
+            bestMove = move;
+            if (score > alpha) {
+                alpha = score;
+                bound = BOUND_EXACT;
+                pv[ply][ply] = move;
+                for (int j = ply + 1; j < pvLength[ply + 1]; ++j)
+                    pv[ply][j] = pv[ply + 1][j];
+                pvLength[ply] = max(pvLength[ply + 1], ply + 1);
+                if (score >= beta) {
+                    bound = BOUND_LOWER;
+                    if (quiet) {
+                        if (killers[ply][0] != move) {
+                            killers[ply][1] = killers[ply][0];
+                            killers[ply][0] = move;
+                        }
+                        int &h = history[us][move.from()][move.to()];
+                        h = min(h + depth * depth, 1 << 20);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    owner.table.store(pos.key, depth, bound, scoreToTT(best, ply), bestMove, inCheck ? 0 : staticEval, &ttStats);
+    return best;
+}
+
+int Search::Worker::quiescence(const Position &pos, int alpha, int beta, int ply) {
+    pvLength[ply] = ply;
+    if (countNode())
+        return 0;
+    selDepth = max(selDepth, ply);
+    if (ply >= MAX_PLY - 1)
+        return evaluate(pos);
+
+    // Moves come before standing pat so a stalemate is a draw, not its evaluation.
+    bool inCheck = isInCheck(pos, pos.sideToMove);
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    if (moves.empty())
+        return inCheck ? -MATE_SCORE + ply : 0;
+
+    int best = -INFINITE_SCORE;
+    if (!inCheck) {
+        // Stand pat: the side to move is never forced to capture.
+        best = evaluate(pos);
+        if (best >= beta)
+            return best;
+        alpha = max(alpha, best);
+    }
+
+    // Only captures and queen promotions, unless evading check.
+    MoveList tactical;
+    for (Move move : moves) {
+        if (inCheck || isCapture(pos, move) || move.promotion() == QUEEN)
+            tactical.push_back(move);
+    }
+    int scores[MoveList::CAPACITY];
+    orderMoves(pos, tactical, scores, Move(), ply);
+
+    for (int i = 0; i < tactical.size(); ++i) {
+        pickMove(tactical, scores, i);
+        Position next = pos;
+        next.makeMove(tactical[i]);
+        int score = -quiescence(next, -beta, -alpha, ply + 1);
+        if (owner.stopped)
+            return 0;
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                if (score >= beta)
+                    break;
+            }
+        }
+    }
+    return best;
+}
@@ -0,0 +1,134 @@
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "MoveGen.hpp"
+#include "Tablebases.hpp"
+#include "TranspositionTable.hpp"
+
+const int MAX_PLY = 128;
+const int INFINITE_SCORE = 32001;
+const int MATE_SCORE = 32000;
+// Scores beyond this are mates, at most MAX_PLY plies away.
+const int MATE_IN_MAX_PLY = MATE_SCORE - MAX_PLY;
+
+// What to stop on. Zero means "no limit" for every field.
+struct SearchLimits {
+    int depth = 0;
+    uint64_t nodes = 0;
+    int64_t moveTimeMs = 0;         // spend exactly this long
+    int64_t timeLeftMs[2] = {0, 0}; // remaining clock per color
+    int64_t incrementMs[2] = {0, 0};
+    int movesToGo = 0;
+    bool infinite = false;          // run until stop()
+    bool ponder = false;            // ignore the clock until ponderhit()
+};
+
+// Reported after every completed iteration.
+struct SearchInfo {
+    int depth = 0;
+    int selDepth = 0;
+    int score = 0;      // centipawns from the side to move, or +-MATE_SCORE - plies
+    uint64_t nodes = 0; // all threads
+    uint64_t nps = 0;
+    int64_t timeMs = 0;
+    uint64_t tbHits = 0; // tablebase probes that gave a result
+    std::vector<Move> pv;
+    std::vector<uint64_t> threadNodes;
+};
+
+struct SearchResult {
+    Move bestMove = Move(); // Move() when the root has no legal move
+    Move ponderMove = Move();
+    int score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    std::vector<uint64_t> threadNodes;
+};
+
+// Principal-variation alpha-beta with iterative deepening, aspiration
+// windows, null-move pruning and late-move reductions.
+//
+// With more than one thread the search runs Lazy SMP: every thread searches
+// the same root and they cooperate only through the shared table. Helpers
+// skip some depths and shuffle quiet move order so they do not duplicate the
+// main thread; the main thread alone handles time control and reporting.
+class Search {
+public:
+    explicit Search(TranspositionTable &table);
+    ~Search();
+
+    void setThreads(int count);
+    int threadCount() const { return int(workers.size()); }
+    // Probes tables inside the search for positions of at most probeLimit
+    // pieces, and at the root keeps only the moves that preserve the
+    // tablebase result. nullptr turns probing off. Not during run().
+    void setTablebases(Tablebases *tables, int probeLimit) {
+        tablebases = tables;
+        tbProbeLimit = probeLimit;
+    }
+
+    // history holds the Zobrist keys of the positions played before root,
+    // oldest first, so repetitions of game positions are scored as draws.
+    SearchResult run(const Position &root, const std::vector<uint64_t> &history, const SearchLimits &limits);
+
+    // Safe to call from any thread; run() returns with the best move so far.
+    // A stop() that arrives before run() starts still applies to it, so
+    // callers that start searches asynchronously cannot lose one; run()
+    // clears the request when it returns.
+    void stop() {
+        stopRequested = true;
+        stopped = true;
+    }
+    // The predicted move was played: the clock limits start applying from now.
+    // Like stop(), it also applies to a run() that is just starting.
+    void ponderhit() {
+        ponderhitRequested = true;
+        ponderhitMs = elapsedMs();
+        pondering = false;
+    }
+    // Drops a stop() or ponderhit() that arrived after run() returned, or
+    // for a search that never called run(), so the next run() is unaffected.
+    void clearRequests() {
+        stopRequested = false;
+        ponderhitRequested = false;
+    }
+    void setInfoCallback(std::function<void(const SearchInfo &)> callback) { infoCallback = std::move(callback); }
+
+private:
+    class Worker; // per-thread search state, defined in Search.cpp
+
+    void checkLimits();
+    int64_t elapsedMs() const;
+    bool timeUp(int64_t limitMs) const;
+    std::vector<uint64_t> threadNodes() const;
+    uint64_t tbHits() const;
+
+    TranspositionTable &table;
+    std::vector<std::unique_ptr<Worker>> workers; // workers[0] is the main thread
+    std::function<void(const SearchInfo &)> infoCallback;
+
+    std::atomic<bool> stopRequested{false}; // set by stop()
+    std::atomic<bool> stopped{false};       // tells every worker to unwind
+    std::atomic<bool> pondering{false};
+    std::atomic<bool> ponderhitRequested{false};
+    std::atomic<int64_t> ponderhitMs{0};    // time limits count from here
+    SearchLimits limits;
+    std::chrono::steady_clock::time_point startTime;
+    int64_t softLimitMs = 0; // do not start another iteration after this
+    int64_t hardLimitMs = 0; // abort the iteration in progress
+
+    MoveList rootMoves; // the moves searched at the root
+    Tablebases *tablebases = nullptr;
+    int tbProbeLimit = 0;
+    int tbPieces = 0;   // probe inside the search up to this many pieces; 0 = never
+    bool tbRoot = false; // rootMoves were filtered by the tables
+    int tbScore = 0;    // and this is what they are worth
+};
+
+#endif // SEARCH_HPP
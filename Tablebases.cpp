@@ -0,0 +1,936 @@
+#include "Tablebases.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "MappedFile.hpp"
+#include "MoveGen.hpp"
+
+using namespace std;
+
+namespace {
+
+const int TB_PIECES = 7;
+// Rank of a root move that wins within the fifty-move rule; DTZ values of
+// seven-piece tables plus the move clock stay far below it.
+const int MAX_RANK = 1 << 18;
+
+#if defined(_WIN32)
+const char PATH_SEPARATOR = ';';
+#else
+const char PATH_SEPARATOR = ':';
+#endif
+
+const unsigned char WDL_MAGIC[4] = { 0x71, 0xE8, 0x23, 0x5D };
+const unsigned char DTZ_MAGIC[4] = { 0xD7, 0x66, 0x0C, 0xA5 };
+
+// Per-table flags in the file.
+enum TableFlag {
+    FLAG_STM = 1,
+    FLAG_MAPPED = 2,
+    FLAG_WIN_PLIES = 4,
+    FLAG_LOSS_PLIES = 8,
+    FLAG_WIDE = 16,
+    FLAG_SINGLE_VALUE = 128
+};
+
+// First byte of a file.
+enum FileFlag { FILE_SPLIT = 1, FILE_HAS_PAWNS = 2 };
+
+const char PIECE_LETTERS[] = "PNBRQK";
+
+uint16_t readLE16(const uint8_t *p) {
+    return uint16_t(p[0] | p[1] << 8);
+}
+
+uint32_t readLE32(const uint8_t *p) {
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+uint32_t readBE32(const uint8_t *p) {
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+}
+
+uint64_t readBE64(const uint8_t *p) {
+    return uint64_t(readBE32(p)) << 32 | readBE32(p + 4);
+}
+
+// Positive above the a1-h8 diagonal, negative below, zero on it.
+int offDiagonal(int sq) {
+    return rankOf(sq) - fileOf(sq);
+}
+
+int signOf(int value) {
+    return (value > 0) - (value < 0);
+}
+
+// Pieces as the files number them: color in bit 3, type + 1 below.
+uint8_t tbPiece(PieceCode p) {
+    return uint8_t(colorOf(p) << 3 | (typeOf(p) + 1));
+}
+
+// Counts of pawns .. queens in four bits each, white in the low 20 bits.
+uint64_t packMaterial(const int counts[2][6]) {
+    uint64_t key = 0;
+    for (int c = 0; c < 2; ++c) {
+        for (int t = PAWN; t < KING; ++t)
+            key |= uint64_t(counts[c][t]) << (20 * c + 4 * t);
+    }
+    return key;
+}
+
+uint64_t materialKey(const Position &pos) {
+    int counts[2][6];
+    for (int c = 0; c < 2; ++c) {
+        for (int t = PAWN; t <= KING; ++t)
+            counts[c][t] = popCount(pos.piecesOf(Color(c), PieceType(t)));
+    }
+    return packMaterial(counts);
+}
+
+// Index tables of the position encoding, shared by every file.
+struct Encoding {
+    int mapPawns[64] = {};    // a2-h7 -> 0..47, larger toward the edges and rank 2
+    int mapB1H1H7[64] = {};   // squares below the a1-h8 diagonal -> 0..27
+    int mapA1D1D4[64] = {};   // the a1-d1-d4 triangle -> 0..9, diagonal last
+    int mapKK[10][64] = {};   // the 462 placements of two kings
+    int binomial[6][64] = {}; // [k][n]: ways to choose k of n
+    int leadPawnIdx[6][64] = {};
+    int leadPawnsSize[6][4] = {};
+
+    Encoding() {
+        int code = 0;
+        for (int sq = 0; sq < 64; ++sq) {
+            if (offDiagonal(sq) < 0)
+                mapB1H1H7[sq] = code++;
+        }
+
+        const int TRIANGLE[10] = { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 }; // a1 b1 c1 d1 b2 c2 d2 c3 d3 d4
+        int diagonal[4], diagonalCount = 0;
+        code = 0;
+        for (int sq : TRIANGLE) {
+            if (offDiagonal(sq) < 0)
+                mapA1D1D4[sq] = code++;
+            else if (!offDiagonal(sq))
+                diagonal[diagonalCount++] = sq;
+        }
+        for (int i = 0; i < diagonalCount; ++i)
+            mapA1D1D4[diagonal[i]] = code++;
+
+        // A first king on the diagonal keeps the second one on or below it.
+        // Placements with both kings on the diagonal come last.
+        int bothOnDiagonal[64][2], bothCount = 0;
+        code = 0;
+        for (int idx = 0; idx < 10; ++idx) {
+            for (int s1 = 0; s1 <= 27; ++s1) {
+                // Squares outside the triangle also read 0; b1 is the real 0.
+                if (mapA1D1D4[s1] != idx || (!idx && s1 != 1))
+                    continue;
+                for (int s2 = 0; s2 < 64; ++s2) {
+                    if ((kingAttacks(s1) | squareBB(s1)) & squareBB(s2))
+                        continue;
+                    if (!offDiagonal(s1) && offDiagonal(s2) > 0)
+                        continue;
+                    if (!offDiagonal(s1) && !offDiagonal(s2)) {
+                        bothOnDiagonal[bothCount][0] = idx;
+                        bothOnDiagonal[bothCount++][1] = s2;
+                    } else {
+                        mapKK[idx][s2] = code++;
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < bothCount; ++i)
+            mapKK[bothOnDiagonal[i][0]][bothOnDiagonal[i][1]] = code++;
+
+        binomial[0][0] = 1;
+        for (int n = 1; n < 64; ++n) {
+            for (int k = 0; k < 6 && k <= n; ++k)
+                binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+        }
+
+        // The leading pawn is the one with the highest mapPawns: every other
+        // pawn must then be on one of the squares numbered below it.
+        int available = 47;
+        for (int leadCount = 1; leadCount <= 5; ++leadCount) {
+            for (int file = 0; file < 4; ++file) {
+                int idx = 0;
+                for (int rank = 1; rank <= 6; ++rank) {
+                    int sq = makeSquare(file, rank);
+                    if (leadCount == 1) {
+                        mapPawns[sq] = available--;
+                        mapPawns[sq ^ 7] = available--;
+                    }
+                    leadPawnIdx[leadCount][sq] = idx;
+                    idx += binomial[leadCount - 1][mapPawns[sq]];
+                }
+                leadPawnsSize[leadCount][file] = idx;
+            }
+        }
+    }
+};
+
+const Encoding encoding;
+
+bool byPawnMap(int a, int b) {
+    return encoding.mapPawns[a] < encoding.mapPawns[b];
+}
+
+// DTZ tables hold nothing useful right before a capture or pawn move; the
+// DTZ of such a move follows from the WDL of the position.
+int dtzBeforeZeroing(WdlScore wdl) {
+    return wdl == WDL_WIN ? 1 : wdl == WDL_CURSED_WIN ? 101 : wdl == WDL_BLESSED_LOSS ? -101 : wdl == WDL_LOSS ? -1 : 0;
+}
+
+bool isCapture(const Position &pos, Move move) {
+    return move.type() == EN_PASSANT || (pos.occupied[~pos.sideToMove] & squareBB(move.to()));
+}
+
+}
+
+namespace detail {
+
+// Decoding data of one of the up to 8 sub-tables of a file: one per side to
+// move, and for pawn endings one per file a-d of the leading pawn. Values
+// are compressed with a canonical Huffman code over symbols that each stand
+// for a pair of shorter symbols (recursive pairing). Pointers reach into the
+// mapped file and multi-byte fields there are read byte by byte.
+struct PairsData {
+    uint8_t flags = 0;
+    uint8_t maxSymLen = 0;
+    uint8_t minSymLen = 0;          // also the value of a single-value table
+    uint32_t numBlocks = 0;
+    size_t blockSize = 0;
+    size_t span = 0;                // a sparse index entry every span values
+    const uint8_t *lowestSym = nullptr;   // little-endian u16 per code length
+    const uint8_t *btree = nullptr;       // 3 bytes per symbol: left and right child
+    const uint8_t *blockLength = nullptr; // little-endian u16 per block: values - 1
+    uint32_t blockLengthSize = 0;
+    const uint8_t *sparseIndex = nullptr; // 6 bytes per entry: u32 block, u16 offset
+    size_t sparseIndexSize = 0;
+    const uint8_t *data = nullptr;
+    vector<uint64_t> base64;        // lowest code of each length, left-aligned
+    vector<uint8_t> symlen;         // values a symbol expands to, minus one
+    uint8_t pieces[TB_PIECES] = {}; // encoding order of the pieces
+    uint64_t groupIdx[TB_PIECES + 1] = {};
+    int groupLen[TB_PIECES + 1] = {}; // pieces encoded together, zero-terminated
+    uint16_t mapIdx[4] = {};          // DTZ value maps per WDL result
+
+    int blockLengthAt(uint32_t block) const { return readLE16(blockLength + 2 * size_t(block)); }
+    int left(int sym) const { return (btree[3 * sym + 1] & 0xF) << 8 | btree[3 * sym]; }
+    int right(int sym) const { return btree[3 * sym + 2] << 4 | btree[3 * sym + 1] >> 4; }
+};
+
+struct SyzygyTable {
+    bool dtz = false;
+    string name; // "KRvK", strong side first
+    uint64_t key = 0;  // material with the strong side white
+    uint64_t key2 = 0; // and black
+    int pieceCount = 0;
+    bool hasPawns = false;
+    bool hasUniquePieces = false;
+    uint8_t pawnCount[2] = {}; // leading color, other color
+
+    atomic<bool> ready{false}; // set once mapping was attempted
+    MappedFile file;
+    const uint8_t *map = nullptr; // DTZ value maps
+    PairsData items[2][4];        // [side to move][leading pawn file]
+
+    PairsData &get(int stm, int file) { return items[dtz ? 0 : stm][hasPawns ? file : 0]; }
+};
+
+}
+
+using detail::PairsData;
+using detail::SyzygyTable;
+
+namespace {
+
+int decompressPairs(const PairsData &d, uint64_t idx) {
+    if (d.flags & FLAG_SINGLE_VALUE)
+        return d.minSymLen;
+
+    // The sparse index points close to the block holding idx; walk from there.
+    uint32_t k = uint32_t(idx / d.span);
+    uint32_t block = readLE32(d.sparseIndex + 6 * size_t(k));
+    int offset = readLE16(d.sparseIndex + 6 * size_t(k) + 4);
+    offset += int(idx % d.span) - int(d.span / 2);
+    while (offset < 0)
+        offset += d.blockLengthAt(--block) + 1;
+    while (offset > d.blockLengthAt(block))
+        offset -= d.blockLengthAt(block++) + 1;
+
+    // Skip whole symbols until the one covering offset.
+    const uint8_t *ptr = d.data + uint64_t(block) * d.blockSize;
+    uint64_t buf64 = readBE64(ptr);
+    ptr += 8;
+    int buf64Size = 64;
+    int sym;
+    while (true) {
+        int len = 0; // code length - minSymLen
+        while (buf64 < d.base64[len])
+            ++len;
+        sym = int((buf64 - d.base64[len]) >> (64 - len - d.minSymLen));
+        sym += readLE16(d.lowestSym + 2 * len);
+        if (offset < d.symlen[sym] + 1)
+            break;
+        offset -= d.symlen[sym] + 1;
+        len += d.minSymLen;
+        buf64 <<= len;
+        buf64Size -= len;
+        if (buf64Size <= 32) {
+            buf64Size += 32;
+            buf64 |= uint64_t(readBE32(ptr)) << (64 - buf64Size);
+            ptr += 4;
+        }
+    }
+
+    // Expand the pair tree down to the single value at offset.
+    while (d.symlen[sym]) {
+        int left = d.left(sym);
+        if (offset < d.symlen[left] + 1) {
+            sym = left;
+        } else {
+            offset -= d.symlen[left] + 1;
+            sym = d.right(sym);
+        }
+    }
+    return d.left(sym);
+}
+
+// DTZ values are stored as ranks by frequency, per WDL result, and in
+// moves rather than plies unless a flag says otherwise.
+int mapDtz(SyzygyTable &e, int file, int value, WdlScore wdl) {
+    static const int WDL_MAP[] = { 1, 3, 0, 2, 0 };
+    const PairsData &d = e.get(0, file);
+    if (d.flags & FLAG_MAPPED) {
+        int i = d.mapIdx[WDL_MAP[wdl + 2]] + value;
+        value = d.flags & FLAG_WIDE ? readLE16(e.map + 2 * i) : e.map[i];
+    }
+    if ((wdl == WDL_WIN && !(d.flags & FLAG_WIN_PLIES)) || (wdl == WDL_LOSS && !(d.flags & FLAG_LOSS_PLIES))
+        || wdl == WDL_CURSED_WIN || wdl == WDL_BLESSED_LOSS)
+        value *= 2;
+    return value + 1;
+}
+
+// Maps pos to its index in the table and decodes the value there. False if
+// this DTZ table only stores the other side to move.
+bool readTable(const Position &pos, SyzygyTable &e, WdlScore wdl, int &value) {
+    int squares[TB_PIECES];
+    uint8_t pieces[TB_PIECES];
+    int size = 0, leadPawnsCount = 0, tbFile = 0;
+    Bitboard leadPawns = 0;
+
+    // Tables are stored with the strong side white and, when both sides have
+    // the same material, with white to move. Anything else is mirrored.
+    bool flip = (e.key == e.key2 && pos.sideToMove == BLACK) || materialKey(pos) != e.key;
+    int flipColor = flip ? 8 : 0;
+    int flipSquares = flip ? 56 : 0;
+    int stm = int(flip) ^ pos.sideToMove;
+
+    // Pawn endings have a sub-table per file of the leading pawn.
+    if (e.hasPawns) {
+        uint8_t lead = e.get(0, 0).pieces[0] ^ flipColor;
+        Bitboard b = leadPawns = pos.piecesOf(Color(lead >> 3), PAWN);
+        while (b)
+            squares[size++] = popLsb(b) ^ flipSquares;
+        leadPawnsCount = size;
+        swap(squares[0], *max_element(squares, squares + leadPawnsCount, byPawnMap));
+        tbFile = min(fileOf(squares[0]), 7 - fileOf(squares[0]));
+    }
+
+    if (e.dtz && (e.get(0, tbFile).flags & FLAG_STM) != stm && !(e.key == e.key2 && !e.hasPawns))
+        return false;
+
+    for (Bitboard b = pos.all() ^ leadPawns; b; ) {
+        int sq = popLsb(b);
+        squares[size] = sq ^ flipSquares;
+        pieces[size++] = tbPiece(pos.pieceOn(sq)) ^ flipColor;
+    }
+    PairsData &d = e.get(stm, tbFile);
+
+    // Put the pieces in the order the table encodes them.
+    for (int i = leadPawnsCount; i < size - 1; ++i) {
+        for (int j = i + 1; j < size; ++j) {
+            if (d.pieces[i] == pieces[j]) {
+                swap(pieces[i], pieces[j]);
+                swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    // Mirror so that the leading piece is on files a-d.
+    if (fileOf(squares[0]) > 3) {
+        for (int i = 0; i < size; ++i)
+            squares[i] ^= 7;
+    }
+
+    uint64_t idx;
+    if (e.hasPawns) {
+        idx = encoding.leadPawnIdx[leadPawnsCount][squares[0]];
+        stable_sort(squares + 1, squares + leadPawnsCount, byPawnMap);
+        for (int i = 1; i < leadPawnsCount; ++i)
+            idx += encoding.binomial[i][encoding.mapPawns[squares[i]]];
+    } else {
+        // Without pawns the board also mirrors vertically and along the
+        // a1-h8 diagonal, so the leading piece ends up in a1-d1-d4.
+        if (rankOf(squares[0]) > 3) {
+            for (int i = 0; i < size; ++i)
+                squares[i] ^= 56;
+        }
+        for (int i = 0; i < d.groupLen[0]; ++i) {
+            if (!offDiagonal(squares[i]))
+                continue;
+            if (offDiagonal(squares[i]) > 0) {
+                for (int j = i; j < size; ++j)
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            }
+            break;
+        }
+
+        if (e.hasUniquePieces) {
+            // The first three pieces together; later squares skip the ones
+            // already taken.
+            int adjust1 = squares[1] > squares[0];
+            int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+            if (offDiagonal(squares[0]))
+                idx = (encoding.mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            else if (offDiagonal(squares[1]))
+                idx = (6 * 63 + rankOf(squares[0]) * 28 + encoding.mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+            else if (offDiagonal(squares[2]))
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + rankOf(squares[0]) * 7 * 28
+                      + (rankOf(squares[1]) - adjust1) * 28 + encoding.mapB1H1H7[squares[2]];
+            else
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + rankOf(squares[0]) * 7 * 6
+                      + (rankOf(squares[1]) - adjust1) * 6 + (rankOf(squares[2]) - adjust2);
+        } else {
+            idx = encoding.mapKK[encoding.mapA1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    // The remaining groups, each as a combination of the squares left free.
+    idx *= d.groupIdx[0];
+    int *groupSq = squares + d.groupLen[0];
+    bool remainingPawns = e.hasPawns && e.pawnCount[1];
+    for (int next = 1; d.groupLen[next]; ++next) {
+        stable_sort(groupSq, groupSq + d.groupLen[next]);
+        uint64_t n = 0;
+        for (int i = 0; i < d.groupLen[next]; ++i) {
+            int adjust = int(count_if(squares, groupSq, [&](int s) { return groupSq[i] > s; }));
+            n += encoding.binomial[i + 1][groupSq[i] - adjust - 8 * remainingPawns];
+        }
+        remainingPawns = false;
+        idx += n * d.groupIdx[next];
+        groupSq += d.groupLen[next];
+    }
+
+    int stored = decompressPairs(d, idx);
+    value = e.dtz ? mapDtz(e, tbFile, stored, wdl) : stored - 2;
+    return true;
+}
+
+// Splits the piece sequence into groups and works out how many indices
+// each group spans, in the order the file asks for.
+void setGroups(const SyzygyTable &e, PairsData &d, const int order[2], int file) {
+    int n = 0, firstLen = e.hasPawns ? 0 : e.hasUniquePieces ? 3 : 2;
+    d.groupLen[n] = 1;
+    for (int i = 1; i < e.pieceCount; ++i) {
+        if (--firstLen > 0 || d.pieces[i] == d.pieces[i - 1])
+            d.groupLen[n]++;
+        else
+            d.groupLen[++n] = 1;
+    }
+    d.groupLen[++n] = 0;
+
+    bool bothPawns = e.hasPawns && e.pawnCount[1];
+    int next = bothPawns ? 2 : 1;
+    int freeSquares = 64 - d.groupLen[0] - (bothPawns ? d.groupLen[1] : 0);
+    uint64_t idx = 1;
+    for (int k = 0; next < n || k == order[0] || k == order[1]; ++k) {
+        if (k == order[0]) {
+            d.groupIdx[0] = idx;
+            idx *= e.hasPawns ? encoding.leadPawnsSize[d.groupLen[0]][file] : e.hasUniquePieces ? 31332 : 462;
+        } else if (k == order[1]) {
+            d.groupIdx[1] = idx;
+            idx *= encoding.binomial[d.groupLen[1]][48 - d.groupLen[0]];
+        } else {
+            d.groupIdx[next] = idx;
+            idx *= encoding.binomial[d.groupLen[next]][freeSquares];
+            freeSquares -= d.groupLen[next++];
+        }
+    }
+    d.groupIdx[n] = idx;
+}
+
+uint8_t setSymlen(PairsData &d, int sym, vector<bool> &visited) {
+    visited[sym] = true;
+    int right = d.right(sym);
+    if (right == 0xFFF)
+        return 0;
+    int left = d.left(sym);
+    if (!visited[left])
+        d.symlen[left] = setSymlen(d, left, visited);
+    if (!visited[right])
+        d.symlen[right] = setSymlen(d, right, visited);
+    return uint8_t(d.symlen[left] + d.symlen[right] + 1);
+}
+
+const uint8_t *setSizes(PairsData &d, const uint8_t *data) {
+    d.flags = *data++;
+    if (d.flags & FLAG_SINGLE_VALUE) {
+        d.minSymLen = *data++;
+        return data;
+    }
+
+    uint64_t tbSize = d.groupIdx[find(d.groupLen, d.groupLen + TB_PIECES, 0) - d.groupLen];
+    d.blockSize = size_t(1) << *data++;
+    d.span = size_t(1) << *data++;
+    d.sparseIndexSize = size_t((tbSize + d.span - 1) / d.span);
+    int padding = *data++;
+    d.numBlocks = readLE32(data);
+    data += 4;
+    // Padded so that the sparse index never points past the end.
+    d.blockLengthSize = d.numBlocks + padding;
+    d.maxSymLen = *data++;
+    d.minSymLen = *data++;
+    d.lowestSym = data;
+
+    // Canonical code: longer codes have lower values, so the lowest code of
+    // each length, left-aligned to 64 bits, decreases with the length.
+    d.base64.assign(d.maxSymLen - d.minSymLen + 1, 0);
+    for (int i = int(d.base64.size()) - 2; i >= 0; --i)
+        d.base64[i] = (d.base64[i + 1] + readLE16(d.lowestSym + 2 * i) - readLE16(d.lowestSym + 2 * (i + 1))) / 2;
+    for (size_t i = 0; i < d.base64.size(); ++i)
+        d.base64[i] <<= 64 - i - d.minSymLen;
+    data += d.base64.size() * 2;
+
+    d.symlen.assign(readLE16(data), 0);
+    data += 2;
+    d.btree = data;
+    vector<bool> visited(d.symlen.size());
+    for (size_t sym = 0; sym < d.symlen.size(); ++sym) {
+        if (!visited[sym])
+            d.symlen[sym] = setSymlen(d, int(sym), visited);
+    }
+    return data + d.symlen.size() * 3 + (d.symlen.size() & 1);
+}
+
+// Fills the sub-tables from a freshly mapped file. False if the file does
+// not match the material it was registered for or ends too early.
+bool setupTable(SyzygyTable &e) {
+    const uint8_t *base = reinterpret_cast<const uint8_t *>(e.file.data());
+    size_t size = e.file.size();
+    if (size < 8 || memcmp(base, e.dtz ? DTZ_MAGIC : WDL_MAGIC, 4) != 0)
+        return false;
+    const uint8_t *data = base + 4;
+    if (bool(*data & FILE_HAS_PAWNS) != e.hasPawns || bool(*data & FILE_SPLIT) != (e.key != e.key2))
+        return false;
+    ++data;
+
+    int sides = !e.dtz && e.key != e.key2 ? 2 : 1;
+    int maxFile = e.hasPawns ? 3 : 0;
+    bool bothPawns = e.hasPawns && e.pawnCount[1];
+    auto align = [base](const uint8_t *p, size_t to) { return p + (to - size_t(p - base) % to) % to; };
+
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i)
+            e.get(i, f) = PairsData();
+        int order[2][2] = { { *data & 0xF, bothPawns ? data[1] & 0xF : 0xF },
+                            { *data >> 4, bothPawns ? data[1] >> 4 : 0xF } };
+        data += 1 + bothPawns;
+        for (int k = 0; k < e.pieceCount; ++k, ++data) {
+            for (int i = 0; i < sides; ++i)
+                e.get(i, f).pieces[k] = i ? *data >> 4 : *data & 0xF;
+        }
+        for (int i = 0; i < sides; ++i)
+            setGroups(e, e.get(i, f), order[i], f);
+    }
+    data = align(data, 2);
+
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            data = setSizes(e.get(i, f), data);
+            if (data > base + size)
+                return false;
+        }
+    }
+
+    if (e.dtz) {
+        e.map = data;
+        for (int f = 0; f <= maxFile; ++f) {
+            PairsData &d = e.get(0, f);
+            if (!(d.flags & FLAG_MAPPED))
+                continue;
+            if (d.flags & FLAG_WIDE) {
+                data = align(data, 2);
+                for (int i = 0; i < 4; ++i) {
+                    d.mapIdx[i] = uint16_t((data - e.map) / 2 + 1);
+                    data += 2 * readLE16(data) + 2;
+                }
+            } else {
+                for (int i = 0; i < 4; ++i) {
+                    d.mapIdx[i] = uint16_t(data - e.map + 1);
+                    data += *data + 1;
+                }
+            }
+        }
+        data = align(data, 2);
+    }
+
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            PairsData &d = e.get(i, f);
+            d.sparseIndex = data;
+            data += d.sparseIndexSize * 6;
+        }
+    }
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            PairsData &d = e.get(i, f);
+            d.blockLength = data;
+            data += size_t(d.blockLengthSize) * 2;
+        }
+    }
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            PairsData &d = e.get(i, f);
+            data = align(data, 64);
+            d.data = data;
+            data += size_t(d.numBlocks) * d.blockSize;
+        }
+    }
+    return data <= base + size;
+}
+
+}
+
+Tablebases::Tablebases() = default;
+
+Tablebases::~Tablebases() = default;
+
+void Tablebases::clear() {
+    index.clear();
+    tables.clear();
+    directories.clear();
+    largest = 0;
+}
+
+int Tablebases::init(const string &paths) {
+    clear();
+    size_t start = 0;
+    while (start <= paths.size()) {
+        size_t end = paths.find(PATH_SEPARATOR, start);
+        if (end == string::npos)
+            end = paths.size();
+        if (end > start)
+            directories.push_back(paths.substr(start, end - start));
+        start = end + 1;
+    }
+    if (directories.empty())
+        return 0;
+
+    // Every material combination of up to seven pieces, strong side first.
+    for (int p1 = PAWN; p1 < KING; ++p1) {
+        PieceType t1 = PieceType(p1);
+        add({ KING, t1, KING });
+        for (int p2 = PAWN; p2 <= p1; ++p2) {
+            PieceType t2 = PieceType(p2);
+            add({ KING, t1, t2, KING });
+            add({ KING, t1, KING, t2 });
+            for (int p3 = PAWN; p3 < KING; ++p3)
+                add({ KING, t1, t2, KING, PieceType(p3) });
+            for (int p3 = PAWN; p3 <= p2; ++p3) {
+                PieceType t3 = PieceType(p3);
+                add({ KING, t1, t2, t3, KING });
+                for (int p4 = PAWN; p4 <= p3; ++p4) {
+                    PieceType t4 = PieceType(p4);
+                    add({ KING, t1, t2, t3, t4, KING });
+                    for (int p5 = PAWN; p5 <= p4; ++p5)
+                        add({ KING, t1, t2, t3, t4, PieceType(p5), KING });
+                    for (int p5 = PAWN; p5 < KING; ++p5)
+                        add({ KING, t1, t2, t3, t4, KING, PieceType(p5) });
+                }
+                for (int p4 = PAWN; p4 < KING; ++p4) {
+                    PieceType t4 = PieceType(p4);
+                    add({ KING, t1, t2, t3, KING, t4 });
+                    for (int p5 = PAWN; p5 <= p4; ++p5)
+                        add({ KING, t1, t2, t3, KING, t4, PieceType(p5) });
+                }
+            }
+            for (int p3 = PAWN; p3 <= p1; ++p3) {
+                for (int p4 = PAWN; p4 <= (p1 == p3 ? p2 : p3); ++p4)
+                    add({ KING, t1, t2, KING, PieceType(p3), PieceType(p4) });
+            }
+        }
+    }
+    return int(tables.size() / 2);
+}
+
+string Tablebases::findFile(const string &name) const {
+    for (const string &directory : directories) {
+        string path = directory + "/" + name;
+        if (ifstream(path, ios::binary))
+            return path;
+    }
+    return string();
+}
+
+// Registers one material combination, given as the strong side's king and
+// pieces, then the weak side's, if its WDL file exists.
+void Tablebases::add(initializer_list<PieceType> pieces) {
+    string name;
+    int counts[2][6] = {};
+    int side = -1;
+    for (PieceType type : pieces) {
+        if (type == KING) {
+            if (side == 0)
+                name += 'v';
+            ++side;
+        }
+        name += PIECE_LETTERS[type];
+        ++counts[side][type];
+    }
+    if (findFile(name + ".rtbw").empty())
+        return;
+
+    unique_ptr<SyzygyTable> wdl(new SyzygyTable);
+    wdl->name = name;
+    wdl->key = packMaterial(counts);
+    swap(counts[0], counts[1]);
+    wdl->key2 = packMaterial(counts);
+    swap(counts[0], counts[1]);
+    wdl->pieceCount = int(pieces.size());
+    wdl->hasPawns = counts[0][PAWN] || counts[1][PAWN];
+    for (int c = 0; c < 2; ++c) {
+        for (int t = PAWN; t < KING; ++t)
+            wdl->hasUniquePieces |= counts[c][t] == 1;
+    }
+    // The side with fewer pawns leads: it compresses better.
+    bool strongLeads = !counts[1][PAWN] || (counts[0][PAWN] && counts[1][PAWN] >= counts[0][PAWN]);
+    wdl->pawnCount[0] = uint8_t(counts[strongLeads ? 0 : 1][PAWN]);
+    wdl->pawnCount[1] = uint8_t(counts[strongLeads ? 1 : 0][PAWN]);
+
+    unique_ptr<SyzygyTable> dtz(new SyzygyTable);
+    dtz->dtz = true;
+    dtz->name = wdl->name;
+    dtz->key = wdl->key;
+    dtz->key2 = wdl->key2;
+    dtz->pieceCount = wdl->pieceCount;
+    dtz->hasPawns = wdl->hasPawns;
+    dtz->hasUniquePieces = wdl->hasUniquePieces;
+    dtz->pawnCount[0] = wdl->pawnCount[0];
+    dtz->pawnCount[1] = wdl->pawnCount[1];
+
+    index[wdl->key] = index[wdl->key2] = make_pair(wdl.get(), dtz.get());
+    largest = max(largest, wdl->pieceCount);
+    tables.push_back(move(wdl));
+    tables.push_back(move(dtz));
+}
+
+// Maps the file on first use; later calls only read the ready flag.
+bool Tablebases::mapTable(SyzygyTable &table) {
+    if (table.ready.load(memory_order_acquire))
+        return table.file.isOpen();
+    lock_guard<mutex> lock(mapMutex);
+    if (!table.ready.load(memory_order_relaxed)) {
+        string path = findFile(table.name + (table.dtz ? ".rtbz" : ".rtbw"));
+        if (!path.empty() && table.file.open(path)) {
+            table.file.adviseRandom();
+            if (!setupTable(table)) {
+                cerr << "Corrupted tablebase " << path << "\n";
+                table.file.close();
+            }
+        }
+        table.ready.store(true, memory_order_release);
+    }
+    return table.file.isOpen();
+}
+
+// The value stored for pos, which is only right if no capture does better.
+int Tablebases::probeTable(const Position &pos, bool dtz, WdlScore wdl, ProbeState &state) {
+    if (popCount(pos.all()) == 2)
+        return WDL_DRAW;
+    auto it = index.find(materialKey(pos));
+    if (it == index.end()) {
+        state = PROBE_FAIL;
+        return 0;
+    }
+    SyzygyTable &table = dtz ? *it->second.second : *it->second.first;
+    if (!mapTable(table)) {
+        state = PROBE_FAIL;
+        return 0;
+    }
+    int value;
+    if (!readTable(pos, table, wdl, value)) {
+        state = PROBE_CHANGE_STM;
+        return 0;
+    }
+    return value;
+}
+
+// The generator stores whatever compresses best for positions where a
+// capture decides the result, so captures are searched before trusting the
+// table. For DTZ, pawn moves count too.
+WdlScore Tablebases::search(const Position &pos, bool checkZeroing, ProbeState &state) {
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    WdlScore best = WDL_LOSS;
+    int zeroingCount = 0;
+    for (Move move : moves) {
+        if (!isCapture(pos, move) && (!checkZeroing || typeOf(pos.pieceOn(move.from())) != PAWN))
+            continue;
+        ++zeroingCount;
+        Position next = pos;
+        next.makeMove(move);
+        WdlScore value = WdlScore(-search(next, false, state));
+        if (state == PROBE_FAIL)
+            return WDL_DRAW;
+        if (value > best) {
+            best = value;
+            if (value >= WDL_WIN) {
+                state = PROBE_ZEROING_BEST_MOVE;
+                return value;
+            }
+        }
+    }
+
+    // With every move searched the table is not needed, and it could be
+    // wrong: it knows nothing of en passant.
+    bool noMoreMoves = zeroingCount && zeroingCount == moves.size();
+    WdlScore value = best;
+    if (!noMoreMoves) {
+        value = WdlScore(probeTable(pos, false, WDL_DRAW, state));
+        if (state == PROBE_FAIL)
+            return WDL_DRAW;
+    }
+    if (best >= value) {
+        state = best > WDL_DRAW || noMoreMoves ? PROBE_ZEROING_BEST_MOVE : PROBE_OK;
+        return best;
+    }
+    state = PROBE_OK;
+    return value;
+}
+
+int Tablebases::dtzSearch(const Position &pos, ProbeState &state) {
+    state = PROBE_OK;
+    WdlScore wdl = search(pos, true, state);
+    if (state == PROBE_FAIL || wdl == WDL_DRAW)
+        return 0;
+    if (state == PROBE_ZEROING_BEST_MOVE)
+        return dtzBeforeZeroing(wdl);
+
+    int dtz = probeTable(pos, true, wdl, state);
+    if (state == PROBE_FAIL)
+        return 0;
+    if (state != PROBE_CHANGE_STM)
+        return (dtz + 100 * (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN)) * signOf(wdl);
+
+    // The table stores the other side to move: take the best reply one ply down.
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    int minDtz = 0xFFFF;
+    for (Move move : moves) {
+        bool zeroing = isCapture(pos, move) || typeOf(pos.pieceOn(move.from())) == PAWN;
+        Position next = pos;
+        next.makeMove(move);
+        if (zeroing) {
+            state = PROBE_OK;
+            dtz = -dtzBeforeZeroing(search(next, false, state));
+        } else {
+            dtz = -dtzSearch(next, state);
+        }
+        if (state == PROBE_FAIL)
+            return 0;
+        if (dtz == 1 && isCheckmate(next))
+            minDtz = 1;
+        if (!zeroing)
+            dtz += signOf(dtz);
+        if (dtz < minDtz && signOf(dtz) == signOf(wdl))
+            minDtz = dtz;
+    }
+    // No legal moves: mated.
+    return minDtz == 0xFFFF ? -1 : minDtz;
+}
+
+bool Tablebases::probeWdl(const Position &pos, WdlScore &wdl) {
+    if (pos.castling || popCount(pos.all()) > largest)
+        return false;
+    ProbeState state = PROBE_OK;
+    wdl = search(pos, false, state);
+    return state != PROBE_FAIL;
+}
+
+bool Tablebases::probeDtz(const Position &pos, int &dtz) {
+    if (pos.castling || popCount(pos.all()) > largest)
+        return false;
+    ProbeState state;
+    dtz = dtzSearch(pos, state);
+    return state != PROBE_FAIL;
+}
+
+// Ranks: MAX_RANK for a win within the fifty-move rule, less the closer the
+// rule gets; the mirror image for losses; 0 for draws. The ceiling stays
+// above any DTZ plus the move clock, so a win never ranks as a loss.
+bool Tablebases::rankByDtz(const Position &pos, bool repeated, const bool drawn[], const MoveList &moves,
+                           int ranks[]) {
+    int clock = pos.halfmoveClock;
+    for (int i = 0; i < moves.size(); ++i) {
+        Position next = pos;
+        next.makeMove(moves[i]);
+        ProbeState state = PROBE_OK;
+        int dtz;
+        if (next.halfmoveClock == 0) {
+            dtz = dtzBeforeZeroing(WdlScore(-search(next, false, state)));
+        } else if (drawn[i]) {
+            dtz = 0;
+        } else {
+            dtz = -dtzSearch(next, state);
+            dtz += signOf(dtz);
+        }
+        if (state == PROBE_FAIL)
+            return false;
+        if (dtz == 2 && isCheckmate(next))
+            dtz = 1;
+        ranks[i] = dtz > 0 ? (dtz + clock <= 99 && !repeated ? MAX_RANK : MAX_RANK - (dtz + clock))
+                 : dtz < 0 ? (-dtz * 2 + clock < 100 ? -MAX_RANK : -MAX_RANK + (-dtz + clock))
+                 : 0;
+    }
+    return true;
+}
+
+bool Tablebases::rankByWdl(const Position &pos, const MoveList &moves, int ranks[]) {
+    static const int WDL_TO_RANK[] = { -MAX_RANK, -MAX_RANK + 101, 0, MAX_RANK - 101, MAX_RANK };
+    for (int i = 0; i < moves.size(); ++i) {
+        Position next = pos;
+        next.makeMove(moves[i]);
+        ProbeState state = PROBE_OK;
+        WdlScore wdl = WdlScore(-search(next, false, state));
+        if (state == PROBE_FAIL)
+            return false;
+        ranks[i] = WDL_TO_RANK[wdl + 2];
+    }
+    return true;
+}
+
+bool Tablebases::filterRootMoves(const Position &pos, bool repeated, const bool drawn[], MoveList &moves, WdlScore &wdl,
+                                 bool &byDtz) {
+    if (pos.castling || popCount(pos.all()) > largest || moves.empty())
+        return false;
+    int ranks[MoveList::CAPACITY];
+    byDtz = rankByDtz(pos, repeated, drawn, moves, ranks);
+    if (!byDtz && !rankByWdl(pos, moves, ranks))
+        return false;
+
+    int best = *max_element(ranks, ranks + moves.size());
+    MoveList kept;
+    for (int i = 0; i < moves.size(); ++i) {
+        if (ranks[i] == best)
+            kept.push_back(moves[i]);
+    }
+    moves = kept;
+    wdl = best >= MAX_RANK - 100 ? WDL_WIN : best > 0 ? WDL_CURSED_WIN : best == 0 ? WDL_DRAW
+        : best > -(MAX_RANK - 100) ? WDL_BLESSED_LOSS : WDL_LOSS;
+    return true;
+}
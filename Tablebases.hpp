@@ -0,0 +1,93 @@
+#ifndef TABLEBASES_HPP
+#define TABLEBASES_HPP
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Move.hpp"
+#include "Position.hpp"
+
+// Result of a tablebase position for the side to move. Cursed wins and
+// blessed losses are wins and losses that the fifty-move rule turns into draws.
+enum WdlScore : int {
+    WDL_LOSS = -2,
+    WDL_BLESSED_LOSS = -1,
+    WDL_DRAW = 0,
+    WDL_CURSED_WIN = 1,
+    WDL_WIN = 2
+};
+
+namespace detail {
+struct SyzygyTable; // one .rtbw or .rtbz file, defined in Tablebases.cpp
+}
+
+// Syzygy endgame tablebases: .rtbw files hold win/draw/loss, .rtbz files the
+// distance to the next capture or pawn move (DTZ). init() only looks for the
+// files; each one is memory-mapped the first time a probe needs it, so
+// gigabytes of tables cost nothing until the game reaches them.
+//
+// Probing is safe from several search threads at once. Positions with
+// castling rights are never in the tables.
+class Tablebases {
+public:
+    Tablebases();
+    ~Tablebases();
+    Tablebases(const Tablebases &) = delete;
+    Tablebases &operator=(const Tablebases &) = delete;
+
+    // Registers the tables found in paths, a list of directories separated
+    // by ':' (';' on Windows), replacing those found before. Returns how many.
+    int init(const std::string &paths);
+    void clear();
+    // Most pieces, kings included, of any table found; 0 without tables.
+    int maxPieces() const { return largest; }
+
+    // False if a table the probe needs is missing or damaged.
+    bool probeWdl(const Position &pos, WdlScore &wdl);
+    // Plies until the next capture or pawn move with best play, positive if
+    // the side to move wins and negative if it loses; 0 for draws. Values
+    // beyond 100 are cursed wins and blessed losses.
+    bool probeDtz(const Position &pos, int &dtz);
+
+    // Keeps only the moves of the root position that preserve its best
+    // result, ranked by DTZ so that a win is converted within the fifty-move
+    // rule, or by WDL alone when the DTZ tables are missing. repeated tells
+    // whether a position has repeated since the last capture or pawn move,
+    // and drawn[i] whether moves[i] draws at once by threefold repetition or
+    // the fifty-move rule. wdl receives the value of the kept moves and byDtz
+    // whether DTZ ranked them. Leaves moves untouched and returns false if
+    // probing fails.
+    bool filterRootMoves(const Position &pos, bool repeated, const bool drawn[], MoveList &moves, WdlScore &wdl,
+                         bool &byDtz);
+
+private:
+    enum ProbeState {
+        PROBE_FAIL,
+        PROBE_OK,
+        PROBE_CHANGE_STM,       // the DTZ table stores the other side to move
+        PROBE_ZEROING_BEST_MOVE // the best move is a capture or pawn move
+    };
+
+    void add(std::initializer_list<PieceType> pieces);
+    std::string findFile(const std::string &name) const;
+    bool mapTable(detail::SyzygyTable &table);
+    int probeTable(const Position &pos, bool dtz, WdlScore wdl, ProbeState &state);
+    WdlScore search(const Position &pos, bool checkZeroing, ProbeState &state);
+    int dtzSearch(const Position &pos, ProbeState &state);
+    bool rankByDtz(const Position &pos, bool repeated, const bool drawn[], const MoveList &moves, int ranks[]);
+    bool rankByWdl(const Position &pos, const MoveList &moves, int ranks[]);
+
+    std::vector<std::string> directories;
+    std::vector<std::unique_ptr<detail::SyzygyTable>> tables;
+    // Material key -> WDL and DTZ table, for both color assignments.
+    std::unordered_map<uint64_t, std::pair<detail::SyzygyTable *, detail::SyzygyTable *>> index;
+    int largest = 0;
+    std::mutex mapMutex; // serializes the first mapping of each file
+};
+
+#endif // TABLEBASES_HPP
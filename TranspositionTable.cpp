@@ -0,0 +1,179 @@
+#include "TranspositionTable.hpp"
+#include <new>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// Layout of Entry::data, low to high bits:
+// move 16 | score 16 | eval 16 | depth 8 | generation 6 + bound 2
+uint64_t pack(Move move, int score, int eval, int depth, uint8_t genBound) {
+    return uint64_t(move.raw())
+           | uint64_t(uint16_t(int16_t(score))) << 16
+           | uint64_t(uint16_t(int16_t(eval))) << 32
+           | uint64_t(uint8_t(int8_t(depth))) << 48
+           | uint64_t(genBound) << 56;
+}
+
+int depthOf(uint64_t data) { return int8_t(data >> 48); }
+uint8_t genBoundOf(uint64_t data) { return uint8_t(data >> 56); }
+Bound boundOf(uint64_t data) { return Bound(data >> 56 & 3); }
+
+}
+
+TranspositionTable::~TranspositionTable() {
+#if defined(__linux__)
+    if (mapped) {
+        munmap(buckets, bucketCount * sizeof(Bucket));
+        return;
+    }
+#endif
+    delete[] buckets;
+}
+
+void TranspositionTable::resize(size_t mb, bool hugePages) {
+#if defined(__linux__)
+    if (mapped)
+        munmap(buckets, bucketCount * sizeof(Bucket));
+    else
+#endif
+        delete[] buckets;
+    buckets = nullptr;
+    mapped = false;
+
+    bucketCount = 1;
+    while (bucketCount * 2 * sizeof(Bucket) <= mb * 1024 * 1024)
+        bucketCount *= 2;
+    megabytes = mb;
+    size_t bytes = bucketCount * sizeof(Bucket);
+
+#if defined(__linux__)
+    if (hugePages) {
+        // Reserved huge pages first, then transparent huge pages as a hint.
+        void *memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory == MAP_FAILED) {
+            memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory != MAP_FAILED)
+                madvise(memory, bytes, MADV_HUGEPAGE);
+        }
+        if (memory != MAP_FAILED) {
+            buckets = static_cast<Bucket *>(memory);
+            for (size_t i = 0; i < bucketCount; ++i)
+                new (&buckets[i]) Bucket();
+            mapped = true;
+        }
+    }
+#else
+    (void)hugePages;
+#endif
+    if (!buckets)
+        buckets = new Bucket[bucketCount];
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < bucketCount; ++i) {
+        for (Entry &e : buckets[i].entries) {
+            e.check.store(0, memory_order_relaxed);
+            e.data.store(0, memory_order_relaxed);
+        }
+    }
+    generation = 0;
+    lock_guard<mutex> lock(statsMutex);
+    totals = TTStats();
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData &out, TTStats *stats) const {
+    if (stats)
+        ++stats->probes;
+    if (!buckets)
+        return false;
+    const Bucket &bucket = buckets[key & (bucketCount - 1)];
+    for (const Entry &e : bucket.entries) {
+        uint64_t data = e.data.load(memory_order_relaxed);
+        if ((e.check.load(memory_order_relaxed) ^ data) != key || boundOf(data) == BOUND_NONE)
+            continue;
+        out.move = Move(uint16_t(data));
+        out.score = int16_t(data >> 16);
+        out.eval = int16_t(data >> 32);
+        out.depth = int8_t(depthOf(data));
+        out.bound = boundOf(data);
+        if (stats)
+            ++stats->hits;
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, Bound bound, int score, Move move, int eval, TTStats *stats) {
+    if (!buckets)
+        return;
+    Bucket &bucket = buckets[key & (bucketCount - 1)];
+    Entry *victim = nullptr;
+    uint64_t victimData = 0;
+    bool sameKey = false;
+    int worst = 1 << 30;
+    for (Entry &e : bucket.entries) {
+        uint64_t data = e.data.load(memory_order_relaxed);
+        if (boundOf(data) == BOUND_NONE || (e.check.load(memory_order_relaxed) ^ data) == key) {
+            victim = &e;
+            victimData = data;
+            sameKey = boundOf(data) != BOUND_NONE;
+            break;
+        }
+        // Prefer evicting shallow entries and entries left over from old searches.
+        int age = ((generation - genBoundOf(data)) & 0xFC) >> 2;
+        int value = depthOf(data) - 8 * age;
+        if (value < worst) {
+            worst = value;
+            victim = &e;
+            victimData = data;
+        }
+    }
+
+    if (sameKey) {
+        // A deeper result for the same position from this search is worth more
+        // than a shallow bound; keep it, but remember a move if it had none.
+        if (bound != BOUND_EXACT && depth + 3 < depthOf(victimData)
+            && (genBoundOf(victimData) & 0xFC) == generation)
+            return;
+        if (move.isNone())
+            move = Move(uint16_t(victimData));
+    } else if (boundOf(victimData) != BOUND_NONE && (genBoundOf(victimData) & 0xFC) == generation && stats) {
+        ++stats->collisions;
+    }
+
+    uint64_t data = pack(move, score, eval, depth, uint8_t(generation | bound));
+    victim->data.store(data, memory_order_relaxed);
+    victim->check.store(key ^ data, memory_order_relaxed);
+    if (stats)
+        ++stats->stores;
+}
+
+int TranspositionTable::hashfull() const {
+    size_t samples = bucketCount < 250 ? bucketCount : 250;
+    if (!buckets)
+        return 0;
+    int used = 0;
+    for (size_t i = 0; i < samples; ++i) {
+        for (const Entry &e : buckets[i].entries) {
+            uint64_t data = e.data.load(memory_order_relaxed);
+            if (boundOf(data) != BOUND_NONE && (genBoundOf(data) & 0xFC) == generation)
+                ++used;
+        }
+    }
+    return samples ? int(used * 1000 / (samples * 4)) : 0;
+}
+
+void TranspositionTable::addStats(const TTStats &stats) {
+    lock_guard<mutex> lock(statsMutex);
+    totals += stats;
+}
+
+TTStats TranspositionTable::getStats() const {
+    lock_guard<mutex> lock(statsMutex);
+    return totals;
+}
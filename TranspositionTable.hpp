@@ -0,0 +1,92 @@
+#ifndef TRANSPOSITION_TABLE_HPP
+#define TRANSPOSITION_TABLE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "Move.hpp"
+
+enum Bound : uint8_t {
+    BOUND_NONE  = 0,
+    BOUND_UPPER = 1, // score is at most this (fail low)
+    BOUND_LOWER = 2, // score is at least this (fail high)
+    BOUND_EXACT = 3
+};
+
+// What a probe returns. Scores are stored as given; adjusting mate scores
+// for the distance from the root is up to the search.
+struct TTData {
+    Move move;
+    int16_t score;
+    int16_t eval;
+    int8_t depth;
+    Bound bound;
+};
+
+// Counters are collected per thread and merged, so probing never touches a
+// shared cache line just to count.
+struct TTStats {
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+    uint64_t stores = 0;
+    uint64_t collisions = 0; // stores that evicted a current-search entry of another position
+
+    TTStats &operator+=(const TTStats &other) {
+        probes += other.probes;
+        hits += other.hits;
+        stores += other.stores;
+        collisions += other.collisions;
+        return *this;
+    }
+};
+
+// Shared hash table of search results. Power-of-two number of 64-byte
+// buckets holding four entries each. Every entry stores key ^ data beside
+// data, so concurrent readers and writers need no locks: a torn entry simply
+// fails verification and reads as a miss.
+class TranspositionTable {
+public:
+    // Holds no memory until resize() is called; probes miss until then.
+    TranspositionTable() = default;
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+    // Reallocates and clears the table. hugePages asks Linux for 2 MB pages.
+    void resize(size_t megabytes, bool hugePages = false);
+    void clear();
+    size_t sizeMb() const { return megabytes; }
+
+    // Starts a new search; entries from older searches become preferred victims.
+    void newSearch() { generation = uint8_t((generation + 4) & 0xFC); }
+
+    bool probe(uint64_t key, TTData &out, TTStats *stats = nullptr) const;
+    void store(uint64_t key, int depth, Bound bound, int score, Move move, int eval, TTStats *stats = nullptr);
+
+    // Approximate fill in permille, sampled from the first buckets.
+    int hashfull() const;
+
+    void addStats(const TTStats &stats);
+    TTStats getStats() const;
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;
+    };
+    struct alignas(64) Bucket {
+        Entry entries[4];
+    };
+
+    Bucket *buckets = nullptr;
+    size_t bucketCount = 0;
+    size_t megabytes = 0;
+    bool mapped = false;
+    uint8_t generation = 0; // upper 6 bits of the genBound byte
+
+    mutable std::mutex statsMutex;
+    TTStats totals;
+};
+
+#endif // TRANSPOSITION_TABLE_HPP
@@ -0,0 +1,51 @@
+#ifndef ZOBRIST_HPP
+#define ZOBRIST_HPP
+
+#include <cstdint>
+#include "Bitboard.hpp"
+
+// Random keys XORed together to form a 64-bit position hash. Generated at
+// compile time with splitmix64, so keys are identical across builds and runs.
+struct ZobristKeys {
+    uint64_t piece[12][64];
+    uint64_t castling[16]; // indexed by the full castling mask; castling[0] == 0
+    uint64_t epFile[8];
+    uint64_t side;         // XORed in when black is to move
+};
+
+namespace detail {
+
+constexpr uint64_t splitMix64(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys() {
+    ZobristKeys keys{};
+    uint64_t state = 0x4368657373ULL;
+    for (int p = 0; p < 12; ++p) {
+        for (int sq = 0; sq < 64; ++sq)
+            keys.piece[p][sq] = splitMix64(state);
+    }
+    uint64_t rights[4] = {};
+    for (int i = 0; i < 4; ++i)
+        rights[i] = splitMix64(state);
+    for (int mask = 0; mask < 16; ++mask) {
+        for (int i = 0; i < 4; ++i) {
+            if (mask & (1 << i))
+                keys.castling[mask] ^= rights[i];
+        }
+    }
+    for (int file = 0; file < 8; ++file)
+        keys.epFile[file] = splitMix64(state);
+    keys.side = splitMix64(state);
+    return keys;
+}
+
+}
+
+inline constexpr ZobristKeys ZOBRIST = detail::makeZobristKeys();
+
+#endif // ZOBRIST_HPP
@@ -0,0 +1,111 @@
+// Measures how the search scales with threads. Every thread count searches
+// the same fixed positions to the same depth with a freshly cleared table,
+// so the only variable between rows is the number of threads.
+//
+// Usage: bench [depth] [--threads 1,2,4,8,16] [--hash MB]
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Search.hpp"
+
+using namespace std;
+
+namespace {
+
+const char *BENCH_FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "2r3k1/pp3ppp/4p3/3p4/3P4/P3PN2/1P3PPP/2R3K1 b - - 0 22",
+};
+
+struct Row {
+    int threads;
+    int64_t timeMs;
+    uint64_t nodes;
+    vector<uint64_t> threadNodes;
+};
+
+void usage() {
+    cerr << "Usage: bench [depth] [--threads 1,2,4,8,16] [--hash MB]\n";
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    int depth = 10;
+    vector<int> threadCounts = { 1, 2, 4, 8, 16 };
+    size_t hashMb = 64;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threadCounts.clear();
+            stringstream list(argv[++i]);
+            for (string item; getline(list, item, ',');)
+                threadCounts.push_back(max(1, atoi(item.c_str())));
+        } else if (!strcmp(argv[i], "--hash") && i + 1 < argc) {
+            hashMb = size_t(atol(argv[++i]));
+        } else if (isdigit(static_cast<unsigned char>(argv[i][0]))) {
+            depth = atoi(argv[i]);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (depth < 1 || threadCounts.empty()) {
+        usage();
+        return 1;
+    }
+
+    TranspositionTable table;
+    table.resize(hashMb);
+    Search search(table);
+    SearchLimits limits;
+    limits.depth = depth;
+
+    vector<Row> rows;
+    for (int threads : threadCounts) {
+        search.setThreads(threads);
+        Row row = { threads, 0, 0, vector<uint64_t>(threads, 0) };
+        for (const char *fen : BENCH_FENS) {
+            Position pos;
+            pos.setFromFen(fen);
+            table.clear();
+            auto start = chrono::steady_clock::now();
+            SearchResult result = search.run(pos, {}, limits);
+            row.timeMs += chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+            row.nodes += result.nodes;
+            for (int t = 0; t < threads; ++t)
+                row.threadNodes[t] += result.threadNodes[t];
+        }
+        rows.push_back(row);
+
+        const Row &base = rows.front();
+        uint64_t nps = row.nodes * 1000 / uint64_t(max<int64_t>(row.timeMs, 1));
+        uint64_t baseNps = base.nodes * 1000 / uint64_t(max<int64_t>(base.timeMs, 1));
+        cout << "Threads: " << setw(2) << threads
+             << "  Time: " << setw(7) << row.timeMs << " ms"
+             << "  Nodes: " << setw(11) << row.nodes
+             << "  NPS: " << setw(10) << nps
+             << fixed << setprecision(2)
+             << "  NPS scaling: " << double(nps) / double(max<uint64_t>(baseNps, 1))
+             << "  Time-to-depth speedup: " << double(base.timeMs) / double(max<int64_t>(row.timeMs, 1))
+             << "\n";
+        cout << "  Per-thread nodes:";
+        for (uint64_t count : row.threadNodes)
+            cout << " " << count;
+        cout << "\n";
+    }
+    return 0;
+}
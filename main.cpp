@@ -1,23 +1,67 @@
 #include <SFML/Graphics.hpp>
+#include <cstdlib>
+#include <string>
 #include "ChessBoard.hpp"
 #include "GameEnhancer.hpp"
+#include "RenderScheduler.hpp"
 using namespace sf;
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Optional: --hash <MB> sets the transposition table size, --large-pages backs it with huge pages,
+    // --threads <N> sets the number of engine search threads, --fps <N> caps the frame rate (0 = no cap),
+    // --book <file> lets the engine play from a Polyglot book, --book-best always picks its top move,
+    // --syzygy <dirs> probes Syzygy tablebases, --syzygy-pieces <N> only for up to N pieces.
+    size_t hashMb = 64;
+    bool hugePages = false;
+    int threads = 1;
+    int maxFps = 60;
+    string bookPath;
+    bool bookBest = false;
+    string syzygyPath;
+    int syzygyPieces = 7;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--hash" && i + 1 < argc)
+            hashMb = static_cast<size_t>(atoi(argv[++i]));
+        else if (arg == "--large-pages")
+            hugePages = true;
+        else if (arg == "--threads" && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (arg == "--fps" && i + 1 < argc)
+            maxFps = atoi(argv[++i]);
+        else if (arg == "--book" && i + 1 < argc)
+            bookPath = argv[++i];
+        else if (arg == "--book-best")
+            bookBest = true;
+        else if (arg == "--syzygy" && i + 1 < argc)
+            syzygyPath = argv[++i];
+        else if (arg == "--syzygy-pieces" && i + 1 < argc)
+            syzygyPieces = atoi(argv[++i]);
+    }
 
     // 1200x800 - вистачить для дошки (800x800) та панелі (400 пікселів справа)
     RenderWindow window(VideoMode(1200, 800), "Chess Game", Style::Titlebar | Style::Close);
 
-    ChessBoard chessBoard;
+    ChessBoard chessBoard(hashMb, hugePages, threads);
+    if (!bookPath.empty())
+        chessBoard.setBook(bookPath, bookBest);
+    if (!syzygyPath.empty())
+        chessBoard.setTablebases(syzygyPath, syzygyPieces);
 
     chessBoard.getEnhancer().setRestartCallback([&chessBoard]() {
-        chessBoard.getEnhancer().reset();
         chessBoard.initBoard();
     });
 
+    // Redraw only when something changed: input, a move, or a clock second ticking.
+    RenderScheduler scheduler(maxFps);
     while (window.isOpen()) {
+        // With the clocks stopped, the engine idle and the last frame drawn,
+        // only the user can change anything: sleep until they do.
+        bool idle = !scheduler.isDirty() && !chessBoard.isThinking() && !chessBoard.getEnhancer().clocksRunning();
         Event event;
-        while (window.pollEvent(event)) {
+        bool haveEvent = idle ? window.waitEvent(event) : window.pollEvent(event);
+        for (; haveEvent; haveEvent = window.pollEvent(event)) {
+            scheduler.inputReceived();
 
             if (event.type == sf::Event::MouseWheelScrolled) {
                 chessBoard.getEnhancer().handleScroll(event.mouseWheelScroll.delta);
@@ -29,9 +73,17 @@ int main() {
             chessBoard.handleEvent(event);
         }
 
+        if (chessBoard.update() || chessBoard.getEnhancer().needsRedraw())
+            scheduler.invalidate();
+
+        if (!scheduler.shouldDraw()) {
+            scheduler.wait();
+            continue;
+        }
         window.clear();
         chessBoard.draw(window);
         window.display();
+        scheduler.frameDrawn();
     }
 
     return 0;
@@ -0,0 +1,202 @@
+// Counts the leaf nodes of the legal move tree. Serves as the correctness
+// oracle for move generation and as its throughput benchmark.
+//
+// Usage: perft <depth> [--fen "<fen>"] [--divide] [--threads N] [--hash MB]
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MoveGen.hpp"
+
+using namespace std;
+
+namespace {
+
+// Heap allocations made by the current thread. Counted by the operator new
+// below, so the report shows whether move generation allocates at all.
+thread_local uint64_t allocations = 0;
+
+}
+
+void *operator new(size_t size) {
+    ++allocations;
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+
+// Both operators above and below replace the global ones, so malloc and free
+// do pair up. GCC 11+ still flags the free() once delete is inlined next to
+// a new-expression, because it cannot see that new was replaced as well.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+const char *START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Shared subtree-count cache. Each entry stores key ^ data next to data, so a
+// torn write by another thread fails verification instead of returning garbage.
+class PerftTable {
+public:
+    explicit PerftTable(size_t megabytes) {
+        size_t count = 1;
+        while (count * 2 * sizeof(Entry) <= megabytes * 1024 * 1024)
+            count *= 2;
+        entries.reset(new Entry[count]);
+        mask = count - 1;
+    }
+
+    bool probe(uint64_t key, int depth, uint64_t &nodes) const {
+        const Entry &e = entries[key & mask];
+        uint64_t data = e.data.load(memory_order_relaxed);
+        uint64_t check = e.check.load(memory_order_relaxed);
+        if ((check ^ data) != key || int(data & 0xFF) != depth)
+            return false;
+        nodes = data >> 8;
+        return true;
+    }
+
+    void store(uint64_t key, int depth, uint64_t nodes) {
+        Entry &e = entries[key & mask];
+        uint64_t data = nodes << 8 | uint64_t(depth);
+        e.data.store(data, memory_order_relaxed);
+        e.check.store(key ^ data, memory_order_relaxed);
+    }
+
+private:
+    struct Entry {
+        atomic<uint64_t> check{0};
+        atomic<uint64_t> data{0};
+    };
+    unique_ptr<Entry[]> entries;
+    size_t mask;
+};
+
+uint64_t perft(const Position &pos, int depth, PerftTable *table) {
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    if (depth == 1)
+        return moves.size();
+
+    uint64_t key = 0, nodes = 0;
+    if (table) {
+        key = pos.key;
+        if (table->probe(key, depth, nodes))
+            return nodes;
+    }
+    for (Move move : moves) {
+        Position next = pos;
+        next.makeMove(move);
+        nodes += perft(next, depth - 1, table);
+    }
+    if (table)
+        table->store(key, depth, nodes);
+    return nodes;
+}
+
+void usage() {
+    cerr << "Usage: perft <depth> [--fen \"<fen>\"] [--divide] [--threads N] [--hash MB]\n";
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    int depth = atoi(argv[1]);
+    string fen = START_FEN;
+    bool divide = false;
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    size_t hashMb = 0;
+    for (int i = 2; i < argc; ++i) {
+        if (!strcmp(argv[i], "--fen") && i + 1 < argc)
+            fen = argv[++i];
+        else if (!strcmp(argv[i], "--divide"))
+            divide = true;
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--hash") && i + 1 < argc)
+            hashMb = size_t(atol(argv[++i]));
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    Position root;
+    if (depth < 1 || !root.setFromFen(fen)) {
+        usage();
+        return 1;
+    }
+    unique_ptr<PerftTable> table;
+    if (hashMb > 0)
+        table.reset(new PerftTable(hashMb));
+
+    auto start = chrono::steady_clock::now();
+
+    // Root moves are handed out one at a time so fast subtrees do not leave threads idle.
+    MoveList rootMoves;
+    generateLegalMoves(root, rootMoves);
+    vector<uint64_t> counts(rootMoves.size(), 0);
+    atomic<int> nextMove{0};
+    atomic<uint64_t> searchAllocations{0};
+    auto worker = [&]() {
+        uint64_t before = allocations;
+        for (int i = nextMove++; i < rootMoves.size(); i = nextMove++) {
+            if (depth == 1) {
+                counts[i] = 1;
+                continue;
+            }
+            Position next = root;
+            next.makeMove(rootMoves[i]);
+            counts[i] = perft(next, depth - 1, table.get());
+        }
+        searchAllocations += allocations - before;
+    };
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool)
+        t.join();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    uint64_t total = 0;
+    for (int i = 0; i < rootMoves.size(); ++i) {
+        if (divide)
+            cout << toUciString(rootMoves[i]) << ": " << counts[i] << "\n";
+        total += counts[i];
+    }
+    if (divide)
+        cout << "\n";
+    cout << "Nodes: " << total << "\n";
+    cout << "Time: " << static_cast<int64_t>(seconds * 1000) << " ms\n";
+    cout << "NPS: " << static_cast<uint64_t>(seconds > 0 ? total / seconds : 0) << "\n";
+    cout << "Heap allocations: " << searchAllocations << "\n";
+    return 0;
+}
@@ -0,0 +1,591 @@
+// Checks Syzygy tablebases against a retrograde analysis of the same
+// endings: every position of each named table, or a random sample of them,
+// is probed and compared with the solved WDL and DTZ. The correctness
+// oracle for the tablebase decoder, as perft is for move generation.
+//
+// Usage: tbcheck <syzygy-path> <table>... [--sample N]
+//
+// Tables are named like their files, strong side first: KQvK KRvK KPvK
+// KQQvKQ, up to five pieces. The endings a capture or promotion leads to
+// are solved as well but not checked. The analysis ignores the fifty-move
+// rule, so positions more than 100 plies from their next capture or pawn
+// move are skipped. Files that store DTZ in moves may read one ply high,
+// which the format allows.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "MoveGen.hpp"
+#include "Tablebases.hpp"
+
+using namespace std;
+
+namespace {
+
+const int MAX_PIECES = 5;
+const char PIECE_LETTERS[] = "PNBRQK";
+
+// What the analysis knows about a position.
+enum Result : uint8_t {
+    PENDING,
+    PENDING_DRAW, // a capture or pawn move already draws, so it cannot lose
+    WON,
+    LOST,
+    DRAWN,
+    INVALID       // overlapping pieces, side not to move in check, or a mirror image
+};
+
+// One material combination. Positions are indexed by side to move, the
+// white king and then each other piece on 64 squares. The board is mirrored
+// so that the white king stands in a1-d1-d4, or on files a-d with pawns.
+struct Solution {
+    vector<PieceCode> pieces; // white king first
+    bool hasPawns = false;
+    uint64_t positions = 0;   // per side to move
+    vector<uint8_t> result;
+    vector<uint16_t> distance; // plies to the next capture, pawn move or mate
+    vector<uint8_t> pending;   // moves not known to lose yet, while undecided
+};
+
+// White king squares a solution keeps, numbered; [1] with pawns.
+struct KingSquares {
+    int code[2][64];
+    int square[2][32];
+
+    KingSquares() {
+        for (int pawns = 0; pawns < 2; ++pawns) {
+            int count = 0;
+            for (int sq = 0; sq < 64; ++sq) {
+                bool kept = fileOf(sq) <= 3 && (pawns || rankOf(sq) <= fileOf(sq));
+                code[pawns][sq] = kept ? count : -1;
+                if (kept)
+                    square[pawns][count++] = sq;
+            }
+        }
+    }
+};
+
+const KingSquares kingSquares;
+
+// The eight symmetries of the board: bit 2 swaps ranks and files, bit 0
+// mirrors the files and bit 1 the ranks.
+int mirror(int sq, int symmetry) {
+    if (symmetry & 4)
+        sq = ((sq >> 3) | (sq << 3)) & 63;
+    if (symmetry & 1)
+        sq ^= 7;
+    if (symmetry & 2)
+        sq ^= 56;
+    return sq;
+}
+
+Bitboard attacksOf(PieceType type, int sq, Bitboard occupied) {
+    switch (type) {
+    case KNIGHT: return knightAttacks(sq);
+    case BISHOP: return bishopAttacks(sq, occupied);
+    case ROOK: return rookAttacks(sq, occupied);
+    case QUEEN: return queenAttacks(sq, occupied);
+    default: return kingAttacks(sq);
+    }
+}
+
+bool isZeroing(const Position &pos, Move move) {
+    return typeOf(pos.pieceOn(move.from())) == PAWN || (pos.occupied[~pos.sideToMove] & squareBB(move.to()));
+}
+
+uint64_t materialKey(const int counts[2][6]) {
+    uint64_t key = 0;
+    for (int c = 0; c < 2; ++c) {
+        for (int t = PAWN; t <= KING; ++t)
+            key |= uint64_t(counts[c][t]) << (4 * (6 * c + t));
+    }
+    return key;
+}
+
+string materialName(const int counts[2][6]) {
+    string name;
+    for (int c = 0; c < 2; ++c) {
+        if (c)
+            name += 'v';
+        for (int t = KING; t >= PAWN; --t)
+            name.append(size_t(counts[c][t]), PIECE_LETTERS[t]);
+    }
+    return name;
+}
+
+// "KRvK" -> piece counts, white first. False unless both sides start with
+// their king and nothing else is a king.
+bool parseMaterial(const string &name, int counts[2][6]) {
+    memset(counts, 0, sizeof(int) * 12);
+    size_t split = name.find('v');
+    if (split == string::npos || name[0] != 'K' || split + 1 >= name.size() || name[split + 1] != 'K')
+        return false;
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (i == split)
+            continue;
+        const char *letter = strchr(PIECE_LETTERS, name[i]);
+        if (!letter || !*letter)
+            return false;
+        ++counts[i > split][letter - PIECE_LETTERS];
+    }
+    return counts[0][KING] == 1 && counts[1][KING] == 1;
+}
+
+class Solver {
+public:
+    // Solves the material, after every ending a capture or promotion from it
+    // leads to. Only kings left is a draw and needs no solution.
+    void solve(const int counts[2][6]);
+    // The solution of the material, which may have been solved with the
+    // colors swapped; null if it was not solved.
+    const Solution *find(const int counts[2][6], bool &swapped) const;
+    // Finds the solution holding pos and its index there. Positions of a
+    // material solved with the colors swapped are mirrored first.
+    const Solution *locate(const Position &pos, uint64_t &idx) const;
+    // Result of pos for the side to move, en passant included. Its
+    // material must have been solved.
+    WdlScore valueOf(const Position &pos) const;
+
+    static uint64_t indexOf(const Solution &s, const int squares[], Color stm);
+    static void decode(const Solution &s, uint64_t idx, int squares[], Color &stm);
+    static void setup(Position &pos, const Solution &s, const int squares[], Color stm);
+
+private:
+    void solveStructure(Solution &s, int advance);
+    void initPosition(Solution &s, uint64_t idx, const int squares[], Color stm);
+    void retract(Solution &s, uint64_t idx, int level);
+
+    map<uint64_t, unique_ptr<Solution>> solutions;
+};
+
+uint64_t Solver::indexOf(const Solution &s, const int squares[], Color stm) {
+    // The smallest index among the mirror images that keep the king.
+    uint64_t best = UINT64_MAX;
+    for (int symmetry = 0; symmetry < (s.hasPawns ? 2 : 8); ++symmetry) {
+        int code = kingSquares.code[s.hasPawns][mirror(squares[0], symmetry)];
+        if (code < 0)
+            continue;
+        uint64_t idx = uint64_t(code);
+        for (size_t i = 1; i < s.pieces.size(); ++i)
+            idx = idx * 64 + uint64_t(mirror(squares[i], symmetry));
+        best = min(best, idx);
+    }
+    return stm * s.positions + best;
+}
+
+void Solver::decode(const Solution &s, uint64_t idx, int squares[], Color &stm) {
+    stm = Color(idx >= s.positions);
+    idx %= s.positions;
+    for (size_t i = s.pieces.size() - 1; i > 0; --i) {
+        squares[i] = int(idx % 64);
+        idx /= 64;
+    }
+    squares[0] = kingSquares.square[s.hasPawns][idx];
+}
+
+void Solver::setup(Position &pos, const Solution &s, const int squares[], Color stm) {
+    pos.clear();
+    for (size_t i = 0; i < s.pieces.size(); ++i)
+        pos.putPiece(s.pieces[i], squares[i]);
+    pos.sideToMove = stm;
+    pos.key = pos.computeKey();
+}
+
+const Solution *Solver::find(const int counts[2][6], bool &swapped) const {
+    int other[2][6];
+    memcpy(other[0], counts[1], sizeof(other[0]));
+    memcpy(other[1], counts[0], sizeof(other[1]));
+    auto it = solutions.find(materialKey(counts));
+    swapped = it == solutions.end();
+    if (swapped)
+        it = solutions.find(materialKey(other));
+    return it == solutions.end() ? nullptr : it->second.get();
+}
+
+const Solution *Solver::locate(const Position &pos, uint64_t &idx) const {
+    int counts[2][6];
+    for (int c = 0; c < 2; ++c) {
+        for (int t = PAWN; t <= KING; ++t)
+            counts[c][t] = popCount(pos.piecesOf(Color(c), PieceType(t)));
+    }
+    bool swapped;
+    const Solution *found = find(counts, swapped);
+    if (!found)
+        return nullptr;
+    const Solution &s = *found;
+    Bitboard pieces[12];
+    memcpy(pieces, pos.pieces, sizeof(pieces));
+    int squares[MAX_PIECES];
+    for (size_t i = 0; i < s.pieces.size(); ++i) {
+        PieceCode p = s.pieces[i];
+        if (swapped)
+            p = makePiece(~colorOf(p), typeOf(p));
+        squares[i] = popLsb(pieces[p]) ^ (swapped ? 56 : 0);
+    }
+    idx = indexOf(s, squares, swapped ? ~pos.sideToMove : pos.sideToMove);
+    return &s;
+}
+
+WdlScore Solver::valueOf(const Position &pos) const {
+    if (popCount(pos.all()) == 2)
+        return WDL_DRAW;
+    uint64_t idx;
+    const Solution *s = locate(pos, idx);
+    if (!s) {
+        cerr << "Unsolved ending reached\n";
+        exit(1);
+    }
+    WdlScore value = s->result[idx] == WON ? WDL_WIN : s->result[idx] == LOST ? WDL_LOSS : WDL_DRAW;
+    if (pos.epSquare == NO_SQUARE)
+        return value;
+
+    // The solution knows nothing of en passant: it only adds a move.
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    WdlScore best = WDL_LOSS;
+    int others = 0;
+    for (Move move : moves) {
+        if (move.type() != EN_PASSANT) {
+            ++others;
+            continue;
+        }
+        Position next = pos;
+        next.makeMove(move);
+        best = max(best, WdlScore(-valueOf(next)));
+    }
+    return others ? max(value, best) : best;
+}
+
+void Solver::solve(const int counts[2][6]) {
+    int total = 0;
+    for (int c = 0; c < 2; ++c) {
+        for (int t = PAWN; t < KING; ++t)
+            total += counts[c][t];
+    }
+    bool swapped;
+    if (!total || find(counts, swapped))
+        return;
+
+    // Captures, promotions and capturing promotions.
+    for (int c = 0; c < 2; ++c) {
+        for (int victim = -1; victim < KING; ++victim) {
+            int next[2][6];
+            memcpy(next, counts, sizeof(next));
+            if (victim >= 0) {
+                if (!next[c ^ 1][victim])
+                    continue;
+                --next[c ^ 1][victim];
+                solve(next);
+            }
+            if (!next[c][PAWN])
+                continue;
+            --next[c][PAWN];
+            for (int promotion = KNIGHT; promotion <= QUEEN; ++promotion) {
+                ++next[c][promotion];
+                solve(next);
+                --next[c][promotion];
+            }
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    unique_ptr<Solution> s(new Solution);
+    s->pieces.push_back(W_KING);
+    s->pieces.push_back(B_KING);
+    for (int c = 0; c < 2; ++c) {
+        for (int t = QUEEN; t >= PAWN; --t)
+            s->pieces.insert(s->pieces.end(), size_t(counts[c][t]), makePiece(Color(c), PieceType(t)));
+    }
+    s->hasPawns = counts[0][PAWN] || counts[1][PAWN];
+    s->positions = s->hasPawns ? 32 : 10;
+    for (size_t i = 1; i < s->pieces.size(); ++i)
+        s->positions *= 64;
+    s->result.assign(2 * s->positions, PENDING);
+    s->distance.assign(2 * s->positions, 0);
+    s->pending.assign(2 * s->positions, 0);
+    Solution &solution = *s;
+    solutions[materialKey(counts)] = move(s);
+
+    // A pawn move only ever advances the pawns, so pawn structures are
+    // solved from the most advanced back and each one only needs its own
+    // positions and those solved before. Structures with a pawn on its last
+    // rank are visited too, so that they are marked invalid.
+    int pawns = counts[0][PAWN] + counts[1][PAWN];
+    for (int advance = 7 * pawns; advance >= 0; --advance)
+        solveStructure(solution, advance);
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Solved " << materialName(counts) << " in " << static_cast<int64_t>(seconds * 1000) << " ms\n";
+}
+
+// How far the pawns have advanced, in ranks.
+int advanceOf(const Solution &s, const int squares[]) {
+    int advance = 0;
+    for (size_t i = 0; i < s.pieces.size(); ++i) {
+        if (s.pieces[i] == W_PAWN)
+            advance += rankOf(squares[i]);
+        else if (s.pieces[i] == B_PAWN)
+            advance += 7 - rankOf(squares[i]);
+    }
+    return advance;
+}
+
+void Solver::initPosition(Solution &s, uint64_t idx, const int squares[], Color stm) {
+    int n = int(s.pieces.size());
+    Bitboard occupied = 0;
+    bool backRankPawn = false;
+    for (int i = 0; i < n; ++i) {
+        occupied |= squareBB(squares[i]);
+        backRankPawn |= typeOf(s.pieces[i]) == PAWN && (squareBB(squares[i]) & (RANK_1 | RANK_8));
+    }
+    Position pos;
+    if (popCount(occupied) != n || backRankPawn || indexOf(s, squares, stm) != idx) {
+        s.result[idx] = INVALID;
+        return;
+    }
+    setup(pos, s, squares, stm);
+    if (isInCheck(pos, ~stm)) {
+        s.result[idx] = INVALID;
+        return;
+    }
+
+    MoveList moves;
+    generateLegalMoves(pos, moves);
+    if (moves.empty()) {
+        s.result[idx] = isInCheck(pos, stm) ? LOST : DRAWN;
+        return;
+    }
+
+    // Captures and pawn moves leave for positions solved before; the other
+    // moves stay here and are counted once per distinct position reached.
+    WdlScore exit = WDL_LOSS;
+    bool exits = false;
+    uint64_t children[MoveList::CAPACITY];
+    int count = 0;
+    for (Move move : moves) {
+        if (isZeroing(pos, move)) {
+            Position next = pos;
+            next.makeMove(move);
+            exit = max(exit, WdlScore(-valueOf(next)));
+            exits = true;
+            continue;
+        }
+        int next[MAX_PIECES];
+        memcpy(next, squares, sizeof(int) * size_t(n));
+        *std::find(next, next + n, move.from()) = move.to();
+        children[count++] = indexOf(s, next, ~stm);
+    }
+    if (exit == WDL_WIN) {
+        s.result[idx] = WON;
+        s.distance[idx] = 1;
+        return;
+    }
+    sort(children, children + count);
+    count = int(unique(children, children + count) - children);
+    if (!count) {
+        s.result[idx] = exit == WDL_LOSS ? LOST : DRAWN;
+        s.distance[idx] = 1;
+        return;
+    }
+    s.result[idx] = exits && exit == WDL_DRAW ? PENDING_DRAW : PENDING;
+    s.pending[idx] = uint8_t(count);
+}
+
+// Takes back every move that could have led to idx, decided at level.
+void Solver::retract(Solution &s, uint64_t idx, int level) {
+    int squares[MAX_PIECES];
+    Color stm;
+    decode(s, idx, squares, stm);
+    int n = int(s.pieces.size());
+    Bitboard occupied = 0;
+    for (int i = 0; i < n; ++i)
+        occupied |= squareBB(squares[i]);
+
+    // Pawn moves reset the fifty-move count like captures, so only pieces
+    // move back.
+    uint64_t parents[256];
+    int count = 0;
+    for (int i = 0; i < n; ++i) {
+        if (colorOf(s.pieces[i]) == stm || typeOf(s.pieces[i]) == PAWN)
+            continue;
+        for (Bitboard from = attacksOf(typeOf(s.pieces[i]), squares[i], occupied) & ~occupied; from; ) {
+            int previous[MAX_PIECES];
+            memcpy(previous, squares, sizeof(int) * size_t(n));
+            previous[i] = popLsb(from);
+            parents[count++] = indexOf(s, previous, ~stm);
+        }
+    }
+    sort(parents, parents + count);
+    count = int(unique(parents, parents + count) - parents);
+
+    bool lost = s.result[idx] == LOST;
+    for (int i = 0; i < count; ++i) {
+        uint64_t parent = parents[i];
+        uint8_t result = s.result[parent];
+        if (result != PENDING && result != PENDING_DRAW)
+            continue;
+        if (lost) {
+            s.result[parent] = WON;
+            s.distance[parent] = uint16_t(level + 1);
+        } else if (!--s.pending[parent]) {
+            s.result[parent] = result == PENDING_DRAW ? DRAWN : LOST;
+            s.distance[parent] = uint16_t(level + 1);
+        }
+    }
+}
+
+void Solver::solveStructure(Solution &s, int advance) {
+    uint64_t size = 2 * s.positions;
+    int squares[MAX_PIECES];
+    Color stm;
+    for (uint64_t idx = 0; idx < size; ++idx) {
+        decode(s, idx, squares, stm);
+        if (advanceOf(s, squares) == advance)
+            initPosition(s, idx, squares, stm);
+    }
+
+    // Mates are decided at level 0 and winning captures at level 1; every
+    // later level follows from the one before.
+    for (int level = 0;; ++level) {
+        bool found = false;
+        for (uint64_t idx = 0; idx < size; ++idx) {
+            if ((s.result[idx] != WON && s.result[idx] != LOST) || s.distance[idx] != level)
+                continue;
+            if (s.hasPawns) {
+                decode(s, idx, squares, stm);
+                if (advanceOf(s, squares) != advance)
+                    continue;
+            }
+            found = true;
+            retract(s, idx, level);
+        }
+        if (!found && level > 0)
+            break;
+    }
+
+    // What is still open can neither be forced nor forced upon.
+    for (uint64_t idx = 0; idx < size; ++idx) {
+        if (s.result[idx] != PENDING && s.result[idx] != PENDING_DRAW)
+            continue;
+        decode(s, idx, squares, stm);
+        if (advanceOf(s, squares) == advance)
+            s.result[idx] = DRAWN;
+    }
+}
+
+// Probes the positions of one table and compares them with the solution.
+// Returns the number of mismatches.
+uint64_t check(Tablebases &tb, Solver &solver, const int counts[2][6], uint64_t sample) {
+    solver.solve(counts);
+    bool swapped;
+    const Solution &s = *solver.find(counts, swapped);
+    Position pos;
+
+    auto start = chrono::steady_clock::now();
+    uint64_t size = 2 * s.positions;
+    mt19937_64 random(20240601);
+    uint64_t checked = 0, wdlErrors = 0, dtzErrors = 0, failures = 0, skipped = 0;
+    int reported = 0;
+    for (uint64_t next = 0; sample ? checked < sample : next < size; ++next) {
+        uint64_t idx = sample ? random() % size : next;
+        if (s.result[idx] == INVALID)
+            continue;
+        if (s.distance[idx] > 100) {
+            ++skipped;
+            continue;
+        }
+        int squares[MAX_PIECES];
+        Color stm;
+        Solver::decode(s, idx, squares, stm);
+        Solver::setup(pos, s, squares, stm);
+        ++checked;
+
+        WdlScore expectedWdl = s.result[idx] == WON ? WDL_WIN : s.result[idx] == LOST ? WDL_LOSS : WDL_DRAW;
+        int expectedDtz = s.result[idx] == WON ? s.distance[idx] : s.result[idx] == LOST ? -max<int>(s.distance[idx], 1) : 0;
+        WdlScore wdl;
+        int dtz;
+        if (!tb.probeWdl(pos, wdl) || !tb.probeDtz(pos, dtz)) {
+            ++failures;
+            if (reported++ < 10)
+                cout << "  probe failed: " << pos.toFen() << "\n";
+            continue;
+        }
+        bool wdlOk = wdl == expectedWdl;
+        bool dtzOk = dtz == expectedDtz || (expectedDtz && dtz == expectedDtz + (expectedDtz > 0 ? 1 : -1));
+        wdlErrors += !wdlOk;
+        dtzErrors += !dtzOk;
+        if ((!wdlOk || !dtzOk) && reported++ < 10)
+            cout << "  " << pos.toFen() << ": expected WDL " << expectedWdl << " DTZ " << expectedDtz
+                 << ", probed WDL " << wdl << " DTZ " << dtz << "\n";
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << materialName(counts) << ": " << checked << " positions, " << wdlErrors << " WDL and " << dtzErrors
+         << " DTZ mismatches, " << failures << " failed probes, " << skipped << " skipped ("
+         << static_cast<int64_t>(seconds * 1000) << " ms)\n";
+    return wdlErrors + dtzErrors + failures;
+}
+
+void usage() {
+    cerr << "Usage: tbcheck <syzygy-path> <table>... [--sample N]\n";
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+    vector<string> names;
+    uint64_t sample = 0;
+    for (int i = 2; i < argc; ++i) {
+        if (!strcmp(argv[i], "--sample") && i + 1 < argc)
+            sample = strtoull(argv[++i], nullptr, 10);
+        else
+            names.push_back(argv[i]);
+    }
+
+    vector<array<array<int, 6>, 2>> tables;
+    for (const string &name : names) {
+        int counts[2][6];
+        int pieces = 0;
+        if (parseMaterial(name, counts)) {
+            for (int c = 0; c < 2; ++c) {
+                for (int t = PAWN; t <= KING; ++t)
+                    pieces += counts[c][t];
+            }
+        }
+        if (!pieces || pieces > MAX_PIECES) {
+            usage();
+            return 1;
+        }
+        array<array<int, 6>, 2> table;
+        for (int c = 0; c < 2; ++c)
+            copy(counts[c], counts[c] + 6, table[c].begin());
+        tables.push_back(table);
+    }
+
+    Tablebases tb;
+    if (!tb.init(argv[1])) {
+        cerr << "No tablebases found in " << argv[1] << "\n";
+        return 1;
+    }
+    Solver solver;
+    uint64_t errors = 0;
+    for (const auto &table : tables) {
+        int counts[2][6];
+        for (int c = 0; c < 2; ++c)
+            copy(table[c].begin(), table[c].end(), counts[c]);
+        errors += check(tb, solver, counts, sample);
+    }
+    return errors ? 1 : 0;
+}
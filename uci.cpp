@@ -0,0 +1,269 @@
+// UCI front end: lets tournament managers and analysis tools drive the engine
+// over stdin/stdout. Uses the same Game rules code as the GUI.
+//
+// Commands are split into string_views of the input line, FENs are parsed in
+// place, and the game, history and line buffers are reused between commands, so replaying a long
+// "position ... moves" list does not allocate per move.
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "EngineWorker.hpp"
+#include "Game.hpp"
+
+using namespace std;
+
+namespace {
+
+const int DEFAULT_HASH_MB = 16;
+const int MAX_HASH_MB = 65536;
+const int MAX_THREADS = 256;
+
+mutex outputMutex; // info lines come from the engine thread
+
+void send(const string &line) {
+    lock_guard<mutex> lock(outputMutex);
+    cout << line << endl;
+}
+
+// Splits a line into whitespace-separated tokens without copying it.
+class Tokenizer {
+public:
+    explicit Tokenizer(string_view line) : rest(line) {}
+
+    string_view next() {
+        size_t start = rest.find_first_not_of(" \t\r");
+        if (start == string_view::npos) {
+            rest = string_view();
+            return rest;
+        }
+        size_t end = rest.find_first_of(" \t\r", start);
+        if (end == string_view::npos)
+            end = rest.size();
+        string_view token = rest.substr(start, end - start);
+        rest.remove_prefix(end);
+        return token;
+    }
+
+    // Everything not yet consumed.
+    string_view remaining() const { return rest; }
+
+private:
+    string_view rest;
+};
+
+int64_t toInt(string_view token) {
+    int64_t value = 0;
+    bool negative = !token.empty() && token[0] == '-';
+    for (size_t i = negative ? 1 : 0; i < token.size() && token[i] >= '0' && token[i] <= '9'; ++i)
+        value = value * 10 + (token[i] - '0');
+    return negative ? -value : value;
+}
+
+string formatScore(int score) {
+    if (score >= MATE_IN_MAX_PLY)
+        return "mate " + to_string((MATE_SCORE - score + 1) / 2);
+    if (score <= -MATE_IN_MAX_PLY)
+        return "mate " + to_string(-(MATE_SCORE + score) / 2);
+    return "cp " + to_string(score);
+}
+
+class UciEngine {
+public:
+    UciEngine() : engine(table) {
+        table.resize(DEFAULT_HASH_MB);
+        engine.setListener([this](const EngineMessage &message) { report(message); });
+    }
+
+    // Returns false on "quit".
+    bool handle(string_view line);
+
+private:
+    void setOption(Tokenizer &tokens);
+    void setPosition(Tokenizer &tokens);
+    void go(Tokenizer &tokens);
+    void report(const EngineMessage &message);
+
+    TranspositionTable table;
+    EngineWorker engine;
+    Game game;
+    bool ownBook = false;
+    string bookFile;
+    bool bookBestMove = false;
+    string syzygyPath;
+    int syzygyProbeLimit = 7;
+};
+
+bool UciEngine::handle(string_view line) {
+    Tokenizer tokens(line);
+    string_view command = tokens.next();
+    if (command == "uci") {
+        send("id name Chess");
+        send("id author Chess developers");
+        send("option name Hash type spin default " + to_string(DEFAULT_HASH_MB) + " min 1 max " + to_string(MAX_HASH_MB));
+        send("option name Threads type spin default 1 min 1 max " + to_string(MAX_THREADS));
+        send("option name Ponder type check default false");
+        send("option name OwnBook type check default false");
+        send("option name BookFile type string default <empty>");
+        send("option name BookBestMove type check default false");
+        send("option name SyzygyPath type string default <empty>");
+        send("option name SyzygyProbeLimit type spin default 7 min 0 max 7");
+        send("uciok");
+    } else if (command == "isready") {
+        // Answered from the engine thread once earlier options (a hash resize,
+        // threads, tablebases) are applied; during a search it must come at once.
+        if (engine.isBusy())
+            send("readyok");
+        else
+            engine.ready();
+    } else if (command == "setoption") {
+        setOption(tokens);
+    } else if (command == "ucinewgame") {
+        engine.newGame();
+        game.reset();
+    } else if (command == "position") {
+        setPosition(tokens);
+    } else if (command == "go") {
+        go(tokens);
+    } else if (command == "stop") {
+        engine.stop();
+    } else if (command == "ponderhit") {
+        engine.ponderhit();
+    } else if (command == "quit") {
+        engine.cancel();
+        return false;
+    }
+    return true;
+}
+
+void UciEngine::setOption(Tokenizer &tokens) {
+    // setoption name <id> value <x>; option names are single words, and the
+    // value runs to the end of the line so paths may contain spaces.
+    string_view name, value;
+    for (string_view token = tokens.next(); !token.empty(); token = tokens.next()) {
+        if (token == "name") {
+            name = tokens.next();
+        } else if (token == "value") {
+            value = tokens.remaining();
+            value.remove_prefix(min(value.find_first_not_of(" \t"), value.size()));
+            value = value.substr(0, value.find_last_not_of(" \t\r") + 1);
+            break;
+        }
+    }
+    if (name == "Hash") {
+        engine.setHash(size_t(clamp<int64_t>(toInt(value), 1, MAX_HASH_MB)));
+    } else if (name == "Threads") {
+        engine.setThreads(int(clamp<int64_t>(toInt(value), 1, MAX_THREADS)));
+    } else if (name == "OwnBook" || name == "BookFile" || name == "BookBestMove") {
+        if (name == "OwnBook")
+            ownBook = value == "true";
+        else if (name == "BookFile")
+            bookFile = value == "<empty>" ? string() : string(value);
+        else
+            bookBestMove = value == "true";
+        engine.setBook(ownBook ? bookFile : string(), bookBestMove);
+    } else if (name == "SyzygyPath" || name == "SyzygyProbeLimit") {
+        if (name == "SyzygyPath")
+            syzygyPath = value == "<empty>" ? string() : string(value);
+        else
+            syzygyProbeLimit = int(clamp<int64_t>(toInt(value), 0, 7));
+        engine.setTablebases(syzygyPath, syzygyProbeLimit);
+    }
+}
+
+void UciEngine::setPosition(Tokenizer &tokens) {
+    string_view token = tokens.next();
+    if (token == "startpos") {
+        game.reset();
+        token = tokens.next();
+    } else if (token == "fen") {
+        // The FEN runs up to "moves" or the end of the line.
+        string_view rest = tokens.remaining();
+        rest.remove_prefix(min(rest.find_first_not_of(" \t"), rest.size()));
+        size_t end = rest.find(" moves");
+        string_view fen = rest.substr(0, end);
+        fen = fen.substr(0, fen.find_last_not_of(" \t\r") + 1);
+        if (!game.reset(fen))
+            return;
+        if (end == string_view::npos)
+            return;
+        tokens = Tokenizer(rest.substr(end));
+        token = tokens.next();
+    } else {
+        return;
+    }
+
+    if (token != "moves")
+        return;
+    for (token = tokens.next(); !token.empty(); token = tokens.next()) {
+        Move move = game.findMove(token);
+        if (move.isNone() || !game.playMove(move))
+            break;
+    }
+}
+
+void UciEngine::go(Tokenizer &tokens) {
+    SearchLimits limits;
+    for (string_view token = tokens.next(); !token.empty(); token = tokens.next()) {
+        if (token == "infinite")
+            limits.infinite = true;
+        else if (token == "ponder")
+            limits.ponder = true;
+        else if (token == "wtime")
+            limits.timeLeftMs[WHITE] = toInt(tokens.next());
+        else if (token == "btime")
+            limits.timeLeftMs[BLACK] = toInt(tokens.next());
+        else if (token == "winc")
+            limits.incrementMs[WHITE] = toInt(tokens.next());
+        else if (token == "binc")
+            limits.incrementMs[BLACK] = toInt(tokens.next());
+        else if (token == "movestogo")
+            limits.movesToGo = int(toInt(tokens.next()));
+        else if (token == "movetime")
+            limits.moveTimeMs = toInt(tokens.next());
+        else if (token == "depth")
+            limits.depth = int(toInt(tokens.next()));
+        else if (token == "nodes")
+            limits.nodes = uint64_t(toInt(tokens.next()));
+    }
+    engine.startSearch(game.getPosition(), game.getKeyHistory(), limits);
+}
+
+// Runs on the engine thread.
+void UciEngine::report(const EngineMessage &message) {
+    if (message.type == ENGINE_READY) {
+        send("readyok");
+        return;
+    }
+    if (message.type == ENGINE_INFO) {
+        const SearchInfo &info = message.info;
+        string line = "info depth " + to_string(info.depth) + " seldepth " + to_string(info.selDepth)
+                      + " score " + formatScore(info.score) + " nodes " + to_string(info.nodes)
+                      + " nps " + to_string(info.nps) + " hashfull " + to_string(table.hashfull())
+                      + " tbhits " + to_string(info.tbHits) + " time " + to_string(info.timeMs) + " pv";
+        for (Move move : info.pv)
+            line += " " + toUciString(move);
+        send(line);
+        return;
+    }
+    const SearchResult &result = message.result;
+    string line = "bestmove " + (result.bestMove.isNone() ? string("0000") : toUciString(result.bestMove));
+    if (!result.ponderMove.isNone())
+        line += " ponder " + toUciString(result.ponderMove);
+    send(line);
+}
+
+}
+
+int main() {
+    ios::sync_with_stdio(false);
+    UciEngine uci;
+    string line;
+    while (getline(cin, line)) {
+        if (!uci.handle(line))
+            break;
+    }
+    return 0;
+}
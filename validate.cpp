@@ -0,0 +1,405 @@
+// Replays every game of a PGN or binary move file and reports illegal moves,
+// results that contradict the final position and per-thread throughput.
+// Used to clean game collections before they are imported.
+//
+// Usage: chess-validate <file> [--threads N] [--fen] [--write-moves FILE]
+//
+// The file is memory-mapped and cut into shards at game boundaries. Each
+// thread owns a contiguous run of shards and, once it is done, steals
+// shards from the far end of the busiest other runs, so uneven games do
+// not leave cores idle.
+//
+// Binary move files start with the magic "CHMV"; each game is a 16-bit
+// little-endian ply count, a result byte (0 "*", 1 "1-0", 2 "0-1",
+// 3 "1/2-1/2") and the moves as 16-bit Move values, played from the
+// initial position. --write-moves writes the legal games of the input in
+// this format, in no particular order; games that start from a FEN tag
+// cannot be stored and are counted as not written.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "MappedFile.hpp"
+#include "MoveGen.hpp"
+#include "Pgn.hpp"
+
+using namespace std;
+
+namespace {
+
+const char MOVE_FILE_MAGIC[4] = { 'C', 'H', 'M', 'V' };
+const char *const RESULTS[4] = { "*", "1-0", "0-1", "1/2-1/2" };
+// Shards are cut at the first game boundary after every multiple of this size.
+const size_t SHARD_BYTES = 1024 * 1024;
+
+struct Shard {
+    size_t begin, end;
+};
+
+// One run of shards per thread. The owner takes from the front, thieves
+// from the back, so each side mostly walks the file forward.
+class ShardQueues {
+public:
+    ShardQueues(const vector<Shard> &shards, int threads) : queues(threads) {
+        for (int t = 0; t < threads; ++t) {
+            queues[t].reset(new Queue);
+            size_t first = shards.size() * t / threads, last = shards.size() * (t + 1) / threads;
+            queues[t]->shards.assign(shards.begin() + first, shards.begin() + last);
+            queues[t]->size = last - first;
+        }
+    }
+
+    // Next shard for thread self; false once every run is empty.
+    bool pop(int self, Shard &out, bool &stolen) {
+        {
+            Queue &own = *queues[self];
+            lock_guard<mutex> lock(own.queueMutex);
+            if (!own.shards.empty()) {
+                out = own.shards.front();
+                own.shards.pop_front();
+                own.size = own.shards.size();
+                stolen = false;
+                return true;
+            }
+        }
+        // Steal from the run with the most work left.
+        for (;;) {
+            int victim = -1;
+            size_t most = 0;
+            for (size_t t = 0; t < queues.size(); ++t) {
+                size_t left = queues[t]->size.load(memory_order_relaxed);
+                if (left > most) {
+                    most = left;
+                    victim = int(t);
+                }
+            }
+            if (victim < 0)
+                return false;
+            Queue &other = *queues[victim];
+            lock_guard<mutex> lock(other.queueMutex);
+            if (other.shards.empty())
+                continue;
+            out = other.shards.back();
+            other.shards.pop_back();
+            other.size = other.shards.size();
+            stolen = true;
+            return true;
+        }
+    }
+
+private:
+    struct Queue {
+        mutex queueMutex;
+        deque<Shard> shards;
+        atomic<size_t> size{0}; // read by thieves without the lock
+    };
+    vector<unique_ptr<Queue>> queues;
+};
+
+struct ThreadStats {
+    uint64_t games = 0;
+    uint64_t plies = 0;
+    uint64_t illegal = 0;
+    uint64_t inconsistent = 0;
+    uint64_t notWritten = 0; // FEN games left out of --write-moves
+    uint64_t shards = 0;
+    uint64_t stolen = 0;
+    double seconds = 0;
+};
+
+// Offset of the first tag section that starts on a line after the one
+// holding offset.
+size_t nextGameStart(string_view text, size_t offset) {
+    size_t line = text.rfind('\n', offset - 1);
+    line = line == string_view::npos ? 0 : line + 1;
+    bool previousWasTag = true; // never cut at the line offset falls in
+    while (line < text.size()) {
+        bool isTag = text[line] == '[';
+        if (isTag && !previousWasTag)
+            return line;
+        if (text[line] != '\n' && text[line] != '\r')
+            previousWasTag = isTag;
+        size_t newline = text.find('\n', line);
+        if (newline == string_view::npos)
+            break;
+        line = newline + 1;
+    }
+    return text.size();
+}
+
+vector<Shard> pgnShards(string_view text) {
+    vector<Shard> shards;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = nextGameStart(text, min(text.size(), begin + SHARD_BYTES));
+        shards.push_back({ begin, end });
+        begin = end;
+    }
+    return shards;
+}
+
+// Walks the game headers only; returns false if the file is truncated. The
+// complete games before a truncated one are still sharded.
+bool moveFileShards(string_view text, vector<Shard> &shards) {
+    size_t begin = sizeof(MOVE_FILE_MAGIC), offset = begin;
+    bool complete = true;
+    while (offset < text.size()) {
+        size_t plies = offset + 3 <= text.size() ? uint8_t(text[offset]) | size_t(uint8_t(text[offset + 1])) << 8 : 0;
+        if (offset + 3 + 2 * plies > text.size()) {
+            complete = false;
+            break;
+        }
+        offset += 3 + 2 * plies;
+        if (offset - begin >= SHARD_BYTES) {
+            shards.push_back({ begin, offset });
+            begin = offset;
+        }
+    }
+    if (offset > begin)
+        shards.push_back({ begin, offset });
+    return complete;
+}
+
+// Mate and stalemate decide the game; the recorded result must agree.
+bool resultMatches(const Position &pos, string_view result) {
+    MoveList legal;
+    generateLegalMoves(pos, legal);
+    if (!legal.empty())
+        return true;
+    if (!isInCheck(pos, pos.sideToMove))
+        return result == "1/2-1/2";
+    return result == (pos.sideToMove == WHITE ? "0-1" : "1-0");
+}
+
+void appendMoveRecord(string &out, const vector<Move> &moves, string_view result) {
+    uint8_t code = 0;
+    for (uint8_t i = 0; i < 4; ++i) {
+        if (result == RESULTS[i])
+            code = i;
+    }
+    size_t plies = min<size_t>(moves.size(), 0xFFFF);
+    out += char(plies & 0xFF);
+    out += char(plies >> 8);
+    out += char(code);
+    for (size_t i = 0; i < plies; ++i) {
+        out += char(moves[i].raw() & 0xFF);
+        out += char(moves[i].raw() >> 8);
+    }
+}
+
+class Validator {
+public:
+    Validator(string_view text, bool binary, bool printFen, ostream *movesOut)
+        : text(text), binary(binary), printFen(printFen), movesOut(movesOut) {}
+
+    void run(ShardQueues &queues, int self, ThreadStats &stats);
+
+private:
+    void pgnShard(const Shard &shard, ThreadStats &stats, string &records);
+    void moveFileShard(const Shard &shard, ThreadStats &stats, string &records);
+    void report(size_t offset, const string &message);
+
+    string_view text;
+    bool binary;
+    bool printFen;
+    ostream *movesOut;
+    mutex outputMutex;
+};
+
+void Validator::run(ShardQueues &queues, int self, ThreadStats &stats) {
+    auto start = chrono::steady_clock::now();
+    string records;
+    Shard shard;
+    bool stolen;
+    while (queues.pop(self, shard, stolen)) {
+        ++stats.shards;
+        stats.stolen += stolen;
+        records.clear();
+        if (binary)
+            moveFileShard(shard, stats, records);
+        else
+            pgnShard(shard, stats, records);
+        if (movesOut && !records.empty()) {
+            lock_guard<mutex> lock(outputMutex);
+            movesOut->write(records.data(), streamsize(records.size()));
+        }
+    }
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void Validator::pgnShard(const Shard &shard, ThreadStats &stats, string &records) {
+    PgnReader reader;
+    reader.setText(text.substr(shard.begin, shard.end - shard.begin));
+    PgnGame game;
+    vector<Move> moves;
+    while (reader.next(game)) {
+        size_t offset = shard.begin + game.offset;
+        moves.clear();
+        PgnReplay replay = replayGame(game, movesOut ? &moves : nullptr);
+        ++stats.games;
+        stats.plies += replay.plies;
+        if (!replay.ok) {
+            ++stats.illegal;
+            report(offset, string(replay.error) + " '" + string(replay.token) + "' after ply " + to_string(replay.plies));
+            continue;
+        }
+        string_view tagResult = game.tag("Result");
+        string_view result = !game.result.empty() ? game.result : tagResult;
+        if ((!tagResult.empty() && !game.result.empty() && tagResult != game.result)
+            || !resultMatches(replay.position, result)) {
+            ++stats.inconsistent;
+            report(offset, "result " + string(result) + " does not match the final position " + replay.position.toFen());
+            continue;
+        }
+        if (printFen)
+            report(offset, replay.position.toFen());
+        if (!movesOut)
+            continue;
+        // The records have no room for a start position.
+        if (!game.tag("FEN").empty())
+            ++stats.notWritten;
+        else
+            appendMoveRecord(records, moves, result);
+    }
+}
+
+void Validator::moveFileShard(const Shard &shard, ThreadStats &stats, string &records) {
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(text.data());
+    size_t offset = shard.begin;
+    while (offset < shard.end) {
+        size_t plies = data[offset] | size_t(data[offset + 1]) << 8;
+        uint8_t code = data[offset + 2];
+        const uint8_t *move = data + offset + 3;
+        Position pos;
+        pos.setStartPosition();
+        size_t played = 0;
+        for (; played < plies; ++played, move += 2) {
+            Move next(uint16_t(move[0] | move[1] << 8));
+            if (!isLegalMove(pos, next))
+                break;
+            pos.makeMove(next);
+        }
+        ++stats.games;
+        stats.plies += played;
+        string_view result = code < 4 ? RESULTS[code] : "";
+        if (played < plies) {
+            ++stats.illegal;
+            report(offset, "illegal move " + toUciString(Move(uint16_t(move[0] | move[1] << 8))) + " after ply " + to_string(played));
+        } else if (result.empty() || !resultMatches(pos, result)) {
+            ++stats.inconsistent;
+            report(offset, "result code " + to_string(code) + " does not match the final position " + pos.toFen());
+        } else {
+            if (printFen)
+                report(offset, pos.toFen());
+            if (movesOut)
+                records.append(text.data() + offset, 3 + 2 * plies);
+        }
+        offset += 3 + 2 * plies;
+    }
+}
+
+void Validator::report(size_t offset, const string &message) {
+    lock_guard<mutex> lock(outputMutex);
+    cout << "offset " << offset << ": " << message << "\n";
+}
+
+void usage() {
+    cerr << "Usage: chess-validate <file> [--threads N] [--fen] [--write-moves FILE]\n";
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    string path, movesPath;
+    int threads = int(max(1u, thread::hardware_concurrency()));
+    bool printFen = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--fen"))
+            printFen = true;
+        else if (!strcmp(argv[i], "--write-moves") && i + 1 < argc)
+            movesPath = argv[++i];
+        else if (path.empty() && argv[i][0] != '-')
+            path = argv[i];
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (path.empty()) {
+        usage();
+        return 1;
+    }
+
+    MappedFile file;
+    if (!file.open(path)) {
+        cerr << "Cannot read " << path << "\n";
+        return 1;
+    }
+    file.adviseSequential();
+    string_view text(file.data(), file.size());
+    bool binary = text.size() >= sizeof(MOVE_FILE_MAGIC) && !memcmp(text.data(), MOVE_FILE_MAGIC, sizeof(MOVE_FILE_MAGIC));
+
+    unique_ptr<ofstream> movesOut;
+    if (!movesPath.empty()) {
+        movesOut.reset(new ofstream(movesPath, ios::binary));
+        movesOut->write(MOVE_FILE_MAGIC, sizeof(MOVE_FILE_MAGIC));
+        if (!*movesOut) {
+            cerr << "Cannot write " << movesPath << "\n";
+            return 1;
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<Shard> shards;
+    if (binary && !moveFileShards(text, shards))
+        cerr << "Warning: " << path << " is truncated; the last game is skipped\n";
+    else if (!binary)
+        shards = pgnShards(text);
+
+    ShardQueues queues(shards, threads);
+    Validator validator(text, binary, printFen, movesOut.get());
+    vector<ThreadStats> stats(threads);
+    vector<thread> pool;
+    for (int t = 1; t < threads; ++t)
+        pool.emplace_back([&, t]() { validator.run(queues, t, stats[t]); });
+    validator.run(queues, 0, stats[0]);
+    for (auto &t : pool)
+        t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    ThreadStats total;
+    for (int t = 0; t < threads; ++t) {
+        const ThreadStats &s = stats[t];
+        cout << "Thread " << t << ": " << s.games << " games, " << s.plies << " plies, "
+             << s.shards << " shards (" << s.stolen << " stolen), "
+             << uint64_t(s.seconds > 0 ? s.plies / s.seconds : 0) << " plies/s\n";
+        total.games += s.games;
+        total.plies += s.plies;
+        total.illegal += s.illegal;
+        total.inconsistent += s.inconsistent;
+        total.notWritten += s.notWritten;
+    }
+    cout << "Games: " << total.games << "\n";
+    cout << "Plies: " << total.plies << "\n";
+    cout << "Illegal: " << total.illegal << "\n";
+    cout << "Inconsistent results: " << total.inconsistent << "\n";
+    if (movesOut)
+        cout << "Not written (FEN start): " << total.notWritten << "\n";
+    cout << "Time: " << int64_t(seconds * 1000) << " ms\n";
+    cout << "Plies/s: " << uint64_t(seconds > 0 ? total.plies / seconds : 0) << "\n";
+    cout << "MB/s: " << uint64_t(seconds > 0 ? text.size() / seconds / 1e6 : 0) << "\n";
+    return total.illegal || total.inconsistent ? 2 : 0;
+}